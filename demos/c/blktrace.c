@@ -40,6 +40,7 @@
 typedef struct
 {
 	volatile GAsyncQueue* q;
+	volatile GAsyncQueue* values;
 } IoLatInfo;
 
 struct io_list
@@ -128,6 +129,7 @@ setup_iolats (void)
 {
 	setup_blktrace();
 	iolat_info.q = g_async_queue_new_full(NULL);
+	iolat_info.values = g_async_queue_new_full(NULL);
 }
 
 static struct blk_io_trace*
@@ -304,7 +306,10 @@ void
 uber_blktrace_next (void)
 {
 	struct blk_io_trace t, *p;
-	int i, n = 0, x, td;
+	int n = 0, td;
+	guint64 x;
+	gdouble val;
+	UberHistogram *lats;
 	GArray *vals;
 	GTimeVal tv1, tv2;
 
@@ -313,8 +318,10 @@ uber_blktrace_next (void)
 	}
 
 	g_get_current_time(&tv1);
-	vals = g_array_new(FALSE, FALSE, sizeof(gint));
-	g_array_set_size(vals, 0);
+	lats = uber_histogram_new(UBER_HEAT_MAP_HISTOGRAM_LOWEST,
+	                          UBER_HEAT_MAP_HISTOGRAM_HIGHEST,
+	                          UBER_HEAT_MAP_HISTOGRAM_PRECISION);
+	vals = g_array_new(FALSE, FALSE, sizeof(gdouble));
 
 	while (read_blktrace(blktrace_fd, &t)) {
 		n++;
@@ -333,7 +340,9 @@ uber_blktrace_next (void)
 				break;
 			}
 			x = t.time - p->time;
-			g_array_append_val(vals, x);
+			val = x / 1000.;
+			uber_histogram_record(lats, val);
+			g_array_append_val(vals, val);
 			g_free(p);
 			break;
 		case __BLK_TA_ISSUE:
@@ -361,32 +370,40 @@ uber_blktrace_next (void)
 	g_get_current_time(&tv2);
 	td = tvdiff(tv1, tv2);
 	g_print("%s %d records %d us %.2f us/record, %d completions, %d outstanding ",
-			G_STRFUNC, n, td, td * 1. / (n?:1), (int)vals->len, io_list_len());
-	for (i=0; i<vals->len; i++)
-		printf("%d ", (int)g_array_index(vals, gint, i) / 1000);
-	printf("\n");
-	g_async_queue_push((GAsyncQueue*)iolat_info.q, vals);
+			G_STRFUNC, n, td, td * 1. / (n?:1),
+			(int)uber_histogram_get_count(lats), io_list_len());
+	g_print("p50 %.0f us p99 %.0f us\n",
+			uber_histogram_get_quantile(lats, 0.5),
+			uber_histogram_get_quantile(lats, 0.99));
+	g_async_queue_push((GAsyncQueue*)iolat_info.q, lats);
+	g_async_queue_push((GAsyncQueue*)iolat_info.values, vals);
 }
 
 gboolean
-uber_blktrace_get (UberHeatMap  *map,       /* IN */
-                   GArray      **values,    /* IN */
-                   gpointer      user_data) /* IN */
+uber_blktrace_get (UberHeatMap   *map,       /* IN */
+                   UberHistogram *histogram, /* IN */
+                   gpointer       user_data) /* IN */
+{
+	UberHistogram *lats;
+
+	while ((lats = g_async_queue_try_pop((GAsyncQueue *)iolat_info.q)) != NULL) {
+		uber_histogram_merge(histogram, lats);
+		uber_histogram_free(lats);
+	}
+	return (uber_histogram_get_count(histogram) > 0);
+}
+
+gboolean
+uber_blktrace_get_values (UberScatter  *scatter,   /* IN */
+                          GArray      **values,    /* OUT */
+                          gpointer      user_data) /* IN */
 {
 	GArray *v;
 	GArray *sum;
-	gdouble val;
-	gint i;
 
-	sum = g_array_sized_new(FALSE, TRUE, sizeof(gdouble), 1 /* map->nbucket */);
-	while ((v = g_async_queue_try_pop((GAsyncQueue *)iolat_info.q)) != NULL) {
-		if (v->len == 0) {
-			continue;
-		}
-		for (i = 0; i < v->len; i++) {
-			val = (gdouble)g_array_index(v, gint, i) / 1000.;
-			g_array_append_val(sum, val);
-		}
+	sum = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	while ((v = g_async_queue_try_pop((GAsyncQueue *)iolat_info.values)) != NULL) {
+		g_array_append_vals(sum, v->data, v->len);
 		g_array_unref(v);
 	}
 	*values = sum;
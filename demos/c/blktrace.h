@@ -21,15 +21,19 @@
 #define __BLKTRACE_H__
 
 #include "uber-heat-map.h"
+#include "uber-scatter.h"
 
 G_BEGIN_DECLS
 
-void     uber_blktrace_init     (void);
-void     uber_blktrace_next     (void);
-gboolean uber_blktrace_get      (UberHeatMap  *map,
-                                 GArray      **values,
-                                 gpointer      user_data);
-void     uber_blktrace_shutdown (void);
+void     uber_blktrace_init       (void);
+void     uber_blktrace_next       (void);
+gboolean uber_blktrace_get        (UberHeatMap   *map,
+                                   UberHistogram *histogram,
+                                   gpointer       user_data);
+gboolean uber_blktrace_get_values (UberScatter   *scatter,
+                                   GArray       **values,
+                                   gpointer       user_data);
+void     uber_blktrace_shutdown   (void);
 
 G_END_DECLS
 
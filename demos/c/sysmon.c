@@ -1,6 +1,7 @@
 #include <ctype.h>
 #include <sys/sysinfo.h>
 #include <stdlib.h>
+#include <string.h>
 #include <dlfcn.h>
 #include <gtk/gtk.h>
 
@@ -52,50 +53,58 @@ smon_get_xevent_info (UberLineGraph *graph,     /* IN */
 	return value;
 }
 
-gdouble
-smon_get_cpu_info (UberLineGraph *graph,     /* IN */
-              guint          line,      /* IN */
-              gpointer       user_data) /* IN */
+static gboolean
+smon_update_cpu_labels (gpointer data) /* IN */
 {
+	gdouble *total = data;
 	gchar *text;
 	gint i;
-	gdouble value = UBER_LINE_GRAPH_NO_VALUE;
 
-	g_assert_cmpint(line, >, 0);
-	g_assert_cmpint(line, <=, cpu_info.len * 2);
-
-	if ((line % 2) == 0) {
-		value = cpu_info.freq[((line - 1) / 2)];
-	} else {
-		i = (line - 1) / 2;
-		value = cpu_info.total[i];
-		/*
-		 * Update label text.
-		 */
-		text = g_strdup_printf("CPU%d  %0.1f %%", i + 1, value);
+	for (i = 0; i < cpu_info.len; i++) {
+		text = g_strdup_printf("CPU%d  %0.1f %%", i + 1, total[i]);
 		uber_label_set_text(UBER_LABEL(cpu_info.labels[i]), text);
 		g_free(text);
 	}
-	return value;
+	g_free(total);
+	return FALSE;
 }
 
-gdouble
-smon_get_net_info (UberLineGraph *graph,     /* IN */
-              guint          line,      /* IN */
-              gpointer       user_data) /* IN */
+void
+smon_push_cpu_info (UberLineGraph *graph) /* IN */
 {
-	gdouble value = UBER_LINE_GRAPH_NO_VALUE;
-	switch (line) {
-	case 1:
-		value = net_info.total_in;
-		break;
-	case 2:
-		value = net_info.total_out;
-		break;
-	default:
-		g_assert_not_reached();
+	gdouble *values;
+	gdouble *total;
+	gint i;
+
+	/*
+	 * Lines alternate between the total and the frequency of each cpu.
+	 */
+	values = g_new(gdouble, cpu_info.len * 2);
+	for (i = 0; i < cpu_info.len; i++) {
+		values[i * 2] = cpu_info.total[i];
+		values[i * 2 + 1] = cpu_info.freq[i];
 	}
-	return value;
+	uber_line_graph_push_row(graph, g_get_monotonic_time(),
+	                         values, cpu_info.len * 2);
+	g_free(values);
+	/*
+	 * Labels may only be touched from the main loop, so hand it a copy of
+	 * the totals.
+	 */
+	total = g_new(gdouble, cpu_info.len);
+	memcpy(total, cpu_info.total, sizeof(gdouble) * cpu_info.len);
+	g_idle_add(smon_update_cpu_labels, total);
+}
+
+void
+smon_push_net_info (UberLineGraph *graph) /* IN */
+{
+	gdouble values[2];
+
+	values[0] = net_info.total_in;
+	values[1] = net_info.total_out;
+	uber_line_graph_push_row(graph, g_get_monotonic_time(),
+	                         values, G_N_ELEMENTS(values));
 }
 
 int
@@ -40,15 +40,11 @@ gboolean smon_cpu_has_freq_scaling (gint cpu);
 void smon_gdk_event_hook (GdkEvent *event, gpointer  data);
 gdouble smon_get_xevent_info (UberLineGraph *graph, guint line, gpointer user_data);
 
-gdouble
-smon_get_cpu_info (UberLineGraph *graph,     /* IN */
-              guint          line,      /* IN */
-              gpointer       user_data);
-
-gdouble
-smon_get_net_info (UberLineGraph *graph,     /* IN */
-              guint          line,      /* IN */
-              gpointer       user_data);
+void
+smon_push_cpu_info (UberLineGraph *graph);
+
+void
+smon_push_net_info (UberLineGraph *graph);
 
 void
 smon_next_cpu_info (void);
@@ -41,14 +41,26 @@ static const gchar *default_colors[] = { "#73d216",
                                          "#ce5c00",
                                          NULL };
 
+typedef struct
+{
+	UberLineGraph *cpu;
+	UberLineGraph *net;
+} SampleGraphs;
+
 static void G_GNUC_NORETURN
-sample_thread (gpointer data)
+sample_thread (SampleGraphs *graphs) /* IN */
 {
 	while (TRUE) {
 		g_usleep(G_USEC_PER_SEC);
 		smon_next_cpu_info();
 		smon_next_cpu_freq_info();
 		smon_next_net_info();
+		/*
+		 * Samples are only handed to the graphs through their queues; the
+		 * main loop never reads the sampler state.
+		 */
+		smon_push_cpu_info(graphs->cpu);
+		smon_push_net_info(graphs->net);
 		if (want_blktrace) {
 			uber_blktrace_next();
 		}
@@ -79,6 +91,7 @@ main (gint   argc,   /* IN */
 	UberRange cpu_range = { 0., 100., 100. };
 	UberRange net_range = { 0., 512., 512. };
 	UberRange ui_range = { 0., 10., 10. };
+	SampleGraphs graphs;
 	GtkWidget *window;
 	GtkWidget *cpu;
 	GtkWidget *net;
@@ -128,8 +141,6 @@ main (gint   argc,   /* IN */
 	uber_line_graph_set_autoscale(UBER_LINE_GRAPH(cpu), FALSE);
 	uber_graph_set_format(UBER_GRAPH(cpu), UBER_GRAPH_FORMAT_PERCENT);
 	uber_line_graph_set_range(UBER_LINE_GRAPH(cpu), &cpu_range);
-	uber_line_graph_set_data_func(UBER_LINE_GRAPH(cpu),
-	                              smon_get_cpu_info, NULL, NULL);
 	for (i = 0; i < nprocs; i++) {
 		mod = i % G_N_ELEMENTS(default_colors);
 		gdk_rgba_parse(&color, default_colors[mod]);
@@ -166,8 +177,6 @@ main (gint   argc,   /* IN */
 	 * Add lines for bytes in/out.
 	 */
 	uber_line_graph_set_range(UBER_LINE_GRAPH(net), &net_range);
-	uber_line_graph_set_data_func(UBER_LINE_GRAPH(net),
-	                              smon_get_net_info, NULL, NULL);
 	uber_graph_set_format(UBER_GRAPH(net), UBER_GRAPH_FORMAT_DIRECT1024);
 	label = uber_label_new();
 	uber_label_set_text(UBER_LABEL(label), "Bytes In");
@@ -184,12 +193,17 @@ main (gint   argc,   /* IN */
 	uber_graph_set_show_ylines(UBER_GRAPH(map), FALSE);
 	gdk_rgba_parse(&color, default_colors[0]);
 	uber_heat_map_set_fg_color(UBER_HEAT_MAP(map), &color);
-	uber_heat_map_set_data_func(UBER_HEAT_MAP(map),
-	                            (UberHeatMapFunc)dummy_scatter_func, NULL, NULL);
+	if (want_blktrace) {
+		uber_heat_map_set_histogram_func(UBER_HEAT_MAP(map),
+		                                 uber_blktrace_get, NULL, NULL);
+	} else {
+		uber_heat_map_set_data_func(UBER_HEAT_MAP(map),
+		                            (UberHeatMapFunc)dummy_scatter_func,
+		                            NULL, NULL);
+	}
 	uber_window_add_graph(UBER_WINDOW(window), UBER_GRAPH(map), "IO Latency");
 	uber_graph_set_show_xlabels(UBER_GRAPH(map), FALSE);
 	gtk_widget_show(map);
-
 	/*
 	 * Configure scatter.
 	 */
@@ -198,8 +212,9 @@ main (gint   argc,   /* IN */
 		gdk_rgba_parse(&color, default_colors[3]);
 		uber_scatter_set_fg_color(UBER_SCATTER(scatter), &color);
 		uber_scatter_set_data_func(UBER_SCATTER(scatter),
-								   (UberScatterFunc)uber_blktrace_get, NULL, NULL);
-		uber_window_add_graph(UBER_WINDOW(window), UBER_GRAPH(scatter), "IOPS By Size");
+		                           uber_blktrace_get_values, NULL, NULL);
+		uber_window_add_graph(UBER_WINDOW(window), UBER_GRAPH(scatter),
+		                      "IOPS By Size");
 		uber_graph_set_show_xlabels(UBER_GRAPH(scatter), TRUE);
 		gtk_widget_show(scatter);
 	}
@@ -243,7 +258,9 @@ main (gint   argc,   /* IN */
 	/*
 	 * Start sampling thread.
 	 */
-	g_thread_new("sample", (GThreadFunc)sample_thread, NULL);
+	graphs.cpu = UBER_LINE_GRAPH(cpu);
+	graphs.net = UBER_LINE_GRAPH(net);
+	g_thread_new("sample", (GThreadFunc)sample_thread, &graphs);
 	gtk_main();
 	/*
 	 * Cleanup after blktrace.
@@ -0,0 +1,200 @@
+/* test-g-ring.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <glib.h>
+
+#include "g-ring.h"
+
+static gint destroyed_sum;
+static guint destroyed_count;
+
+static void
+destroy_int (gpointer data) /* IN */
+{
+	destroyed_sum += *(gint *)data;
+	destroyed_count++;
+}
+
+static void
+reset_destroyed (void)
+{
+	destroyed_sum = 0;
+	destroyed_count = 0;
+}
+
+static void
+test_GRing_append_vals_order (void)
+{
+	GRing *ring;
+	gint vals[4] = { 1, 2, 3, 4 };
+	guint i;
+
+	ring = g_ring_sized_new(sizeof(gint), 8, NULL);
+	g_ring_append_vals(ring, vals, 3);
+	g_assert_cmpuint(ring->pos, ==, 3);
+	for (i = 0; i < 3; i++) {
+		g_assert_cmpint(g_ring_get_index(ring, gint, i), ==, vals[2 - i]);
+	}
+	g_ring_append_val(ring, vals[3]);
+	for (i = 0; i < 4; i++) {
+		g_assert_cmpint(g_ring_get_index(ring, gint, i), ==, vals[3 - i]);
+	}
+	g_ring_unref(ring);
+}
+
+static void
+test_GRing_append_vals_wraparound (void)
+{
+	GRingSpan spans[2];
+	GRing *ring;
+	gint vals[12];
+	guint n_spans;
+	guint s;
+	guint j;
+	gint expected;
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(vals); i++) {
+		vals[i] = i + 1;
+	}
+	ring = g_ring_sized_new(sizeof(gint), 5, NULL);
+	/*
+	 * Append across the end of the buffer.
+	 */
+	g_ring_append_vals(ring, vals, 3);
+	g_ring_append_vals(ring, vals + 3, 4);
+	for (i = 0; i < 5; i++) {
+		g_assert_cmpint(g_ring_get_index(ring, gint, i), ==, vals[6 - i]);
+	}
+	n_spans = g_ring_get_spans(ring, spans);
+	g_assert_cmpuint(n_spans, ==, 2);
+	g_assert_cmpuint(spans[0].len + spans[1].len, ==, 5);
+	expected = 3;
+	for (s = 0; s < n_spans; s++) {
+		for (j = 0; j < spans[s].len; j++) {
+			g_assert_cmpint(((gint *)spans[s].data)[j], ==, expected++);
+		}
+	}
+	/*
+	 * Append more than the ring holds; only the newest are kept.
+	 */
+	g_ring_append_vals(ring, vals, G_N_ELEMENTS(vals));
+	for (i = 0; i < 5; i++) {
+		g_assert_cmpint(g_ring_get_index(ring, gint, i), ==, vals[11 - i]);
+	}
+	g_ring_unref(ring);
+}
+
+static void
+test_GRing_append_vals_destroy_notify (void)
+{
+	GRing *ring;
+	gint vals[10];
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS(vals); i++) {
+		vals[i] = i + 1;
+	}
+	reset_destroyed();
+	ring = g_ring_sized_new(sizeof(gint), 4, destroy_int);
+	/*
+	 * Empty slots are never released.
+	 */
+	g_ring_append_vals(ring, vals, 3);
+	g_assert_cmpuint(destroyed_count, ==, 0);
+	/*
+	 * Overwriting releases the value that was there.
+	 */
+	g_ring_append_vals(ring, vals + 3, 2);
+	g_assert_cmpuint(destroyed_count, ==, 1);
+	g_assert_cmpint(destroyed_sum, ==, 1);
+	/*
+	 * A batch larger than the ring releases every stored value and the
+	 * leading values that could not be kept.
+	 */
+	reset_destroyed();
+	g_ring_append_vals(ring, vals, 10);
+	g_assert_cmpuint(destroyed_count, ==, 10);
+	g_assert_cmpint(destroyed_sum, ==,
+	                (2 + 3 + 4 + 5) + (1 + 2 + 3 + 4 + 5 + 6));
+	/*
+	 * The values still held are released with the ring.
+	 */
+	reset_destroyed();
+	g_ring_unref(ring);
+	g_assert_cmpuint(destroyed_count, ==, 4);
+	g_assert_cmpint(destroyed_sum, ==, 7 + 8 + 9 + 10);
+}
+
+static void
+test_GRing_append_vals_throughput (gconstpointer data) /* IN */
+{
+	guint batch = GPOINTER_TO_UINT(data);
+	GTimer *timer;
+	GRing *ring;
+	gdouble *vals;
+	gdouble elapsed;
+	guint total;
+	guint i;
+	gint first;
+
+	total = g_test_perf() ? (1 << 26) : (1 << 22);
+	vals = g_new0(gdouble, batch);
+	ring = g_ring_sized_new(sizeof(gdouble), 8192, NULL);
+	timer = g_timer_new();
+	for (i = 0; i < total; i += batch) {
+		vals[0] = i;
+		g_ring_append_vals(ring, vals, batch);
+	}
+	elapsed = g_timer_elapsed(timer, NULL);
+	/*
+	 * The first value of the last batch.
+	 */
+	first = batch - 1;
+	g_assert_cmpfloat(g_ring_get_index(ring, gdouble, first), ==,
+	                  (gdouble)(total - batch));
+	g_test_maximized_result(total / MAX(elapsed, 1e-9),
+	                        "%u-element batches: %.0f elements/sec",
+	                        batch, total / MAX(elapsed, 1e-9));
+	g_timer_destroy(timer);
+	g_ring_unref(ring);
+	g_free(vals);
+}
+
+gint
+main (gint   argc,   /* IN */
+      gchar *argv[]) /* IN */
+{
+	g_test_init(&argc, &argv, NULL);
+	g_test_add_func("/GRing/append_vals/order",
+	                test_GRing_append_vals_order);
+	g_test_add_func("/GRing/append_vals/wraparound",
+	                test_GRing_append_vals_wraparound);
+	g_test_add_func("/GRing/append_vals/destroy_notify",
+	                test_GRing_append_vals_destroy_notify);
+	g_test_add_data_func("/GRing/append_vals/throughput/1",
+	                     GUINT_TO_POINTER(1),
+	                     test_GRing_append_vals_throughput);
+	g_test_add_data_func("/GRing/append_vals/throughput/16",
+	                     GUINT_TO_POINTER(16),
+	                     test_GRing_append_vals_throughput);
+	g_test_add_data_func("/GRing/append_vals/throughput/4096",
+	                     GUINT_TO_POINTER(4096),
+	                     test_GRing_append_vals_throughput);
+	return g_test_run();
+}
@@ -0,0 +1,172 @@
+/* test-uber-graph.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+
+#include "uber.h"
+
+static gboolean
+get_values (UberHeatMap  *map,       /* IN */
+            GArray      **values,    /* OUT */
+            gpointer      user_data) /* IN */
+{
+	static const gdouble vals[] = { 10., 20., 20., 30., 70. };
+	guint *n_ticks = user_data;
+
+	/*
+	 * Every tick gets the same values, so the largest count never changes
+	 * after the first tick and only the newest column is drawn each tick.
+	 */
+	*values = g_array_new(FALSE, FALSE, sizeof(gdouble));
+	g_array_append_vals(*values, vals, G_N_ELEMENTS(vals));
+	(*n_ticks)++;
+	return TRUE;
+}
+
+static GtkWidget*
+create_map (guint *n_ticks) /* IN */
+{
+	UberRange range = { 0., 100., 100. };
+	GtkWidget *map;
+
+	map = uber_heat_map_new();
+	uber_heat_map_set_range(UBER_HEAT_MAP(map), &range);
+	uber_heat_map_set_data_func(UBER_HEAT_MAP(map), get_values,
+	                            n_ticks, NULL);
+	uber_graph_set_dps(UBER_GRAPH(map), 4.);
+	uber_graph_set_show_xlabels(UBER_GRAPH(map), FALSE);
+	gtk_widget_set_size_request(map, 300, 120);
+	return map;
+}
+
+static void
+wait_for_ticks (guint *a,       /* IN */
+                guint *b,       /* IN */
+                guint  n_ticks) /* IN */
+{
+	while (*a < n_ticks || *b < n_ticks) {
+		g_main_context_iteration(NULL, TRUE);
+	}
+}
+
+static cairo_surface_t*
+draw_widget (GtkWidget *widget) /* IN */
+{
+	cairo_surface_t *surface;
+	cairo_t *cr;
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+	                                     gtk_widget_get_allocated_width(widget),
+	                                     gtk_widget_get_allocated_height(widget));
+	cr = cairo_create(surface);
+	gtk_widget_draw(widget, cr);
+	cairo_destroy(cr);
+	cairo_surface_flush(surface);
+	return surface;
+}
+
+static void
+assert_same_pixels (cairo_surface_t *a, /* IN */
+                    cairo_surface_t *b) /* IN */
+{
+	gint height;
+	gint stride;
+
+	height = cairo_image_surface_get_height(a);
+	stride = cairo_image_surface_get_stride(a);
+	g_assert_cmpint(cairo_image_surface_get_width(a), ==,
+	                cairo_image_surface_get_width(b));
+	g_assert_cmpint(height, ==, cairo_image_surface_get_height(b));
+	g_assert(memcmp(cairo_image_surface_get_data(a),
+	                cairo_image_surface_get_data(b),
+	                (gsize)stride * height) == 0);
+}
+
+static void
+test_UberGraph_render_to_surface_between_ticks (void)
+{
+	cairo_surface_t *thumb;
+	cairo_surface_t *a;
+	cairo_surface_t *b;
+	GtkWidget *window;
+	GtkWidget *vbox;
+	GtkWidget *map_a;
+	GtkWidget *map_b;
+	guint ticks_a = 0;
+	guint ticks_b = 0;
+
+	/*
+	 * Two graphs fed the same values tick on the same clock.  Only the
+	 * second one is also rendered offscreen, so the window contents of the
+	 * two must stay the same.
+	 */
+	window = gtk_offscreen_window_new();
+	vbox = gtk_box_new(GTK_ORIENTATION_VERTICAL, 0);
+	gtk_box_set_homogeneous(GTK_BOX(vbox), TRUE);
+	map_a = create_map(&ticks_a);
+	map_b = create_map(&ticks_b);
+	gtk_box_pack_start(GTK_BOX(vbox), map_a, TRUE, TRUE, 0);
+	gtk_box_pack_start(GTK_BOX(vbox), map_b, TRUE, TRUE, 0);
+	gtk_container_add(GTK_CONTAINER(window), vbox);
+	gtk_widget_show_all(window);
+	/*
+	 * Let a few columns in so the newest column is not in the first slot.
+	 */
+	wait_for_ticks(&ticks_a, &ticks_b, 3);
+	a = draw_widget(map_a);
+	b = draw_widget(map_b);
+	assert_same_pixels(a, b);
+	cairo_surface_destroy(a);
+	cairo_surface_destroy(b);
+	/*
+	 * Render offscreen between two ticks.  Drawing the window must pick up
+	 * where it left off, both right away and after the next tick.
+	 */
+	thumb = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 64, 32);
+	uber_graph_render_to_surface(UBER_GRAPH(map_b), thumb);
+	cairo_surface_destroy(thumb);
+	a = draw_widget(map_a);
+	b = draw_widget(map_b);
+	assert_same_pixels(a, b);
+	cairo_surface_destroy(a);
+	cairo_surface_destroy(b);
+	wait_for_ticks(&ticks_a, &ticks_b, ticks_a + 1);
+	a = draw_widget(map_a);
+	b = draw_widget(map_b);
+	assert_same_pixels(a, b);
+	cairo_surface_destroy(a);
+	cairo_surface_destroy(b);
+	gtk_widget_destroy(window);
+}
+
+gint
+main (gint   argc,   /* IN */
+      gchar *argv[]) /* IN */
+{
+	g_test_init(&argc, &argv, NULL);
+	/*
+	 * Exit status 77 marks the test as skipped when there is no display.
+	 */
+	if (!gtk_init_check(&argc, &argv)) {
+		return 77;
+	}
+	g_test_add_func("/UberGraph/render_to_surface/between_ticks",
+	                test_UberGraph_render_to_surface_between_ticks);
+	return g_test_run();
+}
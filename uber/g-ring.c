@@ -24,7 +24,7 @@
 #define g_malloc0_n(x,y) g_malloc0(x * y)
 #endif
 
-#define get_element(r,i) ((r)->data + ((r)->elt_size * i))
+#define get_element(r,i) ((r)->data + ((r)->elt_size * (i)))
 
 typedef struct _GRingImpl GRingImpl;
 
@@ -73,7 +73,13 @@ g_ring_sized_new (guint          element_size,
  * @data: (in): A pointer to the array of values.
  * @len: (in): The number of values.
  *
- * Appends @len values located at @data.
+ * Appends @len values located at @data.  The values are stored in order,
+ * so the last value in @data becomes index 0 of the ring.  The copy is
+ * performed with at most two memcpy() runs.
+ *
+ * If @len is larger than the ring, only the trailing values are stored
+ * and the element destroy notify is called for the leading values that
+ * could not be kept.
  *
  * Returns: None.
  * Side effects: None.
@@ -84,27 +90,94 @@ g_ring_append_vals (GRing         *ring,
                     guint          len)
 {
 	GRingImpl *ring_impl = (GRingImpl *)ring;
-	gpointer idx;
-	gint x;
-	gint i;
+	const guint8 *src = data;
+	guint elt_size;
+	guint first;
+	guint i;
 
 	g_return_if_fail(ring_impl != NULL);
+	g_return_if_fail(data != NULL || len == 0);
 
-	for (i = 0; i < len; i++) {
-		x = ring->pos - i;
-		x = (x >= 0) ? x : ring->len + x;
-		idx = ring->data + (ring_impl->elt_size * x);
-		if (ring_impl->destroy && ring_impl->looped == TRUE) {
-			ring_impl->destroy(idx);
+	if (len == 0 || ring->len == 0) {
+		return;
+	}
+	elt_size = ring_impl->elt_size;
+	/*
+	 * Values that would be overwritten again within this same call are
+	 * never copied.  They are released immediately instead.
+	 */
+	if (len > ring->len) {
+		if (ring_impl->destroy) {
+			for (i = 0; i < len - ring->len; i++) {
+				ring_impl->destroy((gpointer)(src + (i * elt_size)));
+			}
 		}
-		memcpy(idx, data, ring_impl->elt_size);
-		ring->pos++;
-		if (ring->pos >= ring->len) {
-			ring_impl->looped = TRUE;
+		src += (len - ring->len) * elt_size;
+		len = ring->len;
+	}
+	/*
+	 * The write is split into the run up to the end of the buffer and the
+	 * run that wraps around to the beginning.
+	 */
+	first = MIN(len, ring->len - ring->pos);
+	if (ring_impl->destroy) {
+		if (ring_impl->looped) {
+			for (i = 0; i < first; i++) {
+				ring_impl->destroy(get_element(ring_impl, ring->pos + i));
+			}
+		}
+		for (i = 0; i < len - first; i++) {
+			ring_impl->destroy(get_element(ring_impl, i));
 		}
-		ring->pos %= ring->len;
-		data += ring_impl->elt_size;
 	}
+	memcpy(get_element(ring_impl, ring->pos), src, first * elt_size);
+	if (len > first) {
+		memcpy(ring->data, src + (first * elt_size), (len - first) * elt_size);
+	}
+	if (ring->pos + len >= ring->len) {
+		ring_impl->looped = TRUE;
+	}
+	ring->pos = (ring->pos + len) % ring->len;
+}
+
+/**
+ * g_ring_get_spans:
+ * @ring: (in): A #GRing.
+ * @spans: (out): A location for up to two #GRingSpan.
+ *
+ * Retrieves the elements stored within @ring as contiguous runs of
+ * memory.  The spans are in chronological order; the first element of
+ * @spans[0] is the oldest value and the last element of the last span is
+ * the most recently appended value.  Unused spans are set to zero length.
+ *
+ * This allows consumers to walk the contents of the ring in a tight loop
+ * rather than resolving the wraparound for every index.
+ *
+ * Returns: The number of non-empty spans, 0, 1 or 2.
+ * Side effects: None.
+ */
+guint
+g_ring_get_spans (GRing     *ring,
+                  GRingSpan  spans[2])
+{
+	GRingImpl *ring_impl = (GRingImpl *)ring;
+	guint n_spans = 0;
+
+	g_return_val_if_fail(ring_impl != NULL, 0);
+	g_return_val_if_fail(spans != NULL, 0);
+
+	memset(spans, 0, sizeof(GRingSpan) * 2);
+	if (ring_impl->looped && ring->pos < ring->len) {
+		spans[n_spans].data = get_element(ring_impl, ring->pos);
+		spans[n_spans].len = ring->len - ring->pos;
+		n_spans++;
+	}
+	if (ring->pos > 0) {
+		spans[n_spans].data = ring->data;
+		spans[n_spans].len = ring->pos;
+		n_spans++;
+	}
+	return n_spans;
 }
 
 /**
@@ -138,11 +211,79 @@ g_ring_foreach (GRing    *ring,
 	}
 }
 
+/**
+ * g_ring_resize:
+ * @ring: (in): A #GRing.
+ * @len: (in): The new number of elements.
+ *
+ * Changes the number of elements @ring can hold.  The newest values are
+ * preserved in order; if the ring shrinks below the number of stored
+ * values, the oldest values are released with the element destroy notify.
+ *
+ * The contents are compacted into a single new allocation.  When growing,
+ * the additional slots are zero filled and are located at the indexes
+ * just past the preserved values, i.e. they may be initialized with
+ * g_ring_get_index() starting at the old number of values.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+g_ring_resize (GRing *ring,
+               guint  len)
+{
+	GRingImpl *ring_impl = (GRingImpl *)ring;
+	GRingSpan spans[2];
+	guint8 *data;
+	guint8 *src;
+	guint elt_size;
+	guint n_spans;
+	guint copied = 0;
+	guint skip;
+	guint drop;
+	guint i;
+	guint j;
+
+	g_return_if_fail(ring_impl != NULL);
+
+	if (len == ring->len) {
+		return;
+	}
+	elt_size = ring_impl->elt_size;
+	n_spans = g_ring_get_spans(ring, spans);
+	skip = spans[0].len + spans[1].len;
+	skip = (skip > len) ? skip - len : 0;
+	data = g_malloc0_n(len, elt_size);
+	/*
+	 * Walk the values oldest to newest, releasing the ones that no longer
+	 * fit and compacting the rest to the start of the new allocation.
+	 */
+	for (i = 0; i < n_spans; i++) {
+		src = spans[i].data;
+		drop = MIN(skip, spans[i].len);
+		if (ring_impl->destroy) {
+			for (j = 0; j < drop; j++) {
+				ring_impl->destroy(src + (j * elt_size));
+			}
+		}
+		skip -= drop;
+		memcpy(data + (copied * elt_size), src + (drop * elt_size),
+		       (spans[i].len - drop) * elt_size);
+		copied += spans[i].len - drop;
+	}
+	g_free(ring->data);
+	ring->data = data;
+	ring->len = len;
+	ring->pos = len ? (copied % len) : 0;
+	ring_impl->looped = (len > 0 && copied == len);
+}
+
 /**
  * g_ring_destroy:
  * @ring: (in): A #GRing.
  *
- * Cleans up after a #GRing that is no longer in use.
+ * Cleans up after a #GRing that is no longer in use.  The element destroy
+ * notify is called for every element still stored within the ring.
  *
  * Returns: None.
  * Side effects: None.
@@ -151,10 +292,23 @@ void
 g_ring_destroy (GRing *ring)
 {
 	GRingImpl *ring_impl = (GRingImpl *)ring;
+	GRingSpan spans[2];
+	guint n_spans;
+	guint i;
+	guint j;
 
 	g_return_if_fail(ring != NULL);
 	g_return_if_fail(ring_impl->ref_count == 0);
 
+	if (ring_impl->destroy) {
+		n_spans = g_ring_get_spans(ring, spans);
+		for (i = 0; i < n_spans; i++) {
+			for (j = 0; j < spans[i].len; j++) {
+				ring_impl->destroy((guint8 *)spans[i].data
+				                   + (j * ring_impl->elt_size));
+			}
+		}
+	}
 	g_free(ring_impl->data);
 	g_slice_free(GRingImpl, ring_impl);
 }
@@ -29,7 +29,8 @@ G_BEGIN_DECLS
  * @val: A value to append to the #GRing.
  *
  * Appends a value to the ring buffer.  @val must be a variable as it is
- * referenced to.
+ * referenced to.  To append many values at once, in order, use
+ * g_ring_append_vals().
  *
  * Returns: None.
  * Side effects: None.
@@ -55,7 +56,7 @@ G_BEGIN_DECLS
  * Side effects: None.
  */
 #define g_ring_get_index(ring, type, i)                               \
-    (((type*)(ring)->data)[(((gint)(ring)->pos - 1 - (i)) >= 0) ?     \
+    (((type*)(ring)->data)[(((gint)(ring)->pos - 1 - (gint)(i)) >= 0) ?     \
                             ((ring)->pos - 1 - (i)) :                 \
                             ((ring)->len + ((ring)->pos - 1 - (i)))])
 
@@ -66,6 +67,19 @@ typedef struct
 	guint   pos;
 } GRing;
 
+/**
+ * GRingSpan:
+ * @data: A pointer to the first element of the span.
+ * @len: The number of elements in the span.
+ *
+ * A contiguous run of elements within a #GRing.  See g_ring_get_spans().
+ */
+typedef struct
+{
+	gpointer data;
+	guint    len;
+} GRingSpan;
+
 GType  g_ring_get_type    (void) G_GNUC_CONST;
 GRing* g_ring_sized_new   (guint           element_size,
                            guint           reserved_size,
@@ -76,6 +90,10 @@ void   g_ring_append_vals (GRing          *ring,
 void   g_ring_foreach     (GRing          *ring,
                            GFunc           func,
                            gpointer        user_data);
+guint  g_ring_get_spans   (GRing          *ring,
+                           GRingSpan       spans[2]);
+void   g_ring_resize      (GRing          *ring,
+                           guint           len);
 GRing* g_ring_ref         (GRing          *ring);
 void   g_ring_unref       (GRing          *ring);
 
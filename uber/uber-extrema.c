@@ -0,0 +1,257 @@
+/* uber-extrema.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "uber-extrema.h"
+
+#define DEQUE_INDEX(d, i) (((d)->head + (i)) % (d)->len)
+#define DEQUE_FRONT(d)    ((d)->entries[(d)->head])
+#define DEQUE_BACK(d)     ((d)->entries[DEQUE_INDEX((d), (d)->count - 1)])
+
+/**
+ * uber_extrema_deque_grow:
+ * @deque: An #UberExtremaDeque.
+ *
+ * Doubles the capacity of @deque, moving its entries to the start of the
+ * new allocation.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_extrema_deque_grow (UberExtremaDeque *deque) /* IN */
+{
+	UberExtremaEntry *entries;
+	guint len;
+	guint run;
+
+	len = MAX(16, deque->len * 2);
+	entries = g_new(UberExtremaEntry, len);
+	if (deque->count) {
+		run = MIN(deque->count, deque->len - deque->head);
+		memcpy(entries, deque->entries + deque->head,
+		       run * sizeof(UberExtremaEntry));
+		memcpy(entries + run, deque->entries,
+		       (deque->count - run) * sizeof(UberExtremaEntry));
+	}
+	g_free(deque->entries);
+	deque->entries = entries;
+	deque->len = len;
+	deque->head = 0;
+}
+
+/**
+ * uber_extrema_deque_push:
+ * @deque: An #UberExtremaDeque.
+ * @time: The time of the value.
+ * @value: The value.
+ * @is_max: If @deque tracks the maximum rather than the minimum.
+ *
+ * Pushes a value onto the back of @deque after dropping every entry it
+ * dominates.  Those entries are older and no better, so they can never be
+ * the extreme of any later window.
+ *
+ * Values pushed out of order are treated as if they arrived with the
+ * newest time seen, which keeps the deque sorted by time at the cost of
+ * keeping such a value a little longer than its own time would.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_extrema_deque_push (UberExtremaDeque *deque,  /* IN */
+                         gint64            time,   /* IN */
+                         gdouble           value,  /* IN */
+                         gboolean          is_max) /* IN */
+{
+	UberExtremaEntry *entry;
+
+	if (time < deque->last_time) {
+		time = deque->last_time;
+	}
+	deque->last_time = time;
+	while (deque->count) {
+		entry = &DEQUE_BACK(deque);
+		if (is_max ? (entry->value > value) : (entry->value < value)) {
+			break;
+		}
+		deque->count--;
+	}
+	if (deque->count == deque->len) {
+		uber_extrema_deque_grow(deque);
+	}
+	entry = &deque->entries[DEQUE_INDEX(deque, deque->count)];
+	entry->time = time;
+	entry->value = value;
+	deque->count++;
+}
+
+/**
+ * uber_extrema_deque_expire:
+ * @deque: An #UberExtremaDeque.
+ * @before: The oldest time to keep.
+ *
+ * Removes entries older than @before from the front of @deque.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_extrema_deque_expire (UberExtremaDeque *deque,  /* IN */
+                           gint64            before) /* IN */
+{
+	while (deque->count && DEQUE_FRONT(deque).time < before) {
+		deque->head = (deque->head + 1) % deque->len;
+		deque->count--;
+	}
+}
+
+/**
+ * uber_extrema_init:
+ * @extrema: An #UberExtrema.
+ *
+ * Initializes @extrema with an empty window.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_extrema_init (UberExtrema *extrema) /* IN */
+{
+	g_return_if_fail(extrema != NULL);
+
+	memset(extrema, 0, sizeof(*extrema));
+	extrema->min.last_time = G_MININT64;
+	extrema->max.last_time = G_MININT64;
+}
+
+/**
+ * uber_extrema_destroy:
+ * @extrema: An #UberExtrema.
+ *
+ * Releases the memory held by @extrema.  It must be initialized again
+ * before it is reused.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_extrema_destroy (UberExtrema *extrema) /* IN */
+{
+	g_return_if_fail(extrema != NULL);
+
+	g_free(extrema->min.entries);
+	g_free(extrema->max.entries);
+	memset(extrema, 0, sizeof(*extrema));
+}
+
+/**
+ * uber_extrema_clear:
+ * @extrema: An #UberExtrema.
+ *
+ * Removes every value from the window.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_extrema_clear (UberExtrema *extrema) /* IN */
+{
+	g_return_if_fail(extrema != NULL);
+
+	extrema->min.count = 0;
+	extrema->max.count = 0;
+	extrema->min.last_time = G_MININT64;
+	extrema->max.last_time = G_MININT64;
+}
+
+/**
+ * uber_extrema_push:
+ * @extrema: An #UberExtrema.
+ * @time: The time of @value.
+ * @value: The value.
+ *
+ * Adds a value to the window.  %NAN values are ignored.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_extrema_push (UberExtrema *extrema, /* IN */
+                   gint64       time,    /* IN */
+                   gdouble      value)   /* IN */
+{
+	g_return_if_fail(extrema != NULL);
+
+	if (!isnan(value)) {
+		uber_extrema_deque_push(&extrema->min, time, value, FALSE);
+		uber_extrema_deque_push(&extrema->max, time, value, TRUE);
+	}
+}
+
+/**
+ * uber_extrema_expire:
+ * @extrema: An #UberExtrema.
+ * @before: The oldest time to keep.
+ *
+ * Slides the start of the window forward to @before.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_extrema_expire (UberExtrema *extrema, /* IN */
+                     gint64       before)  /* IN */
+{
+	g_return_if_fail(extrema != NULL);
+
+	uber_extrema_deque_expire(&extrema->min, before);
+	uber_extrema_deque_expire(&extrema->max, before);
+}
+
+/**
+ * uber_extrema_get:
+ * @extrema: An #UberExtrema.
+ * @min: (out): A location for the minimum, or %NULL.
+ * @max: (out): A location for the maximum, or %NULL.
+ *
+ * Retrieves the minimum and maximum of the values in the window.
+ *
+ * Returns: %TRUE if the window holds any values; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_extrema_get (UberExtrema *extrema, /* IN */
+                  gdouble     *min,     /* OUT */
+                  gdouble     *max)     /* OUT */
+{
+	g_return_val_if_fail(extrema != NULL, FALSE);
+
+	if (!extrema->max.count) {
+		return FALSE;
+	}
+	if (min) {
+		*min = DEQUE_FRONT(&extrema->min).value;
+	}
+	if (max) {
+		*max = DEQUE_FRONT(&extrema->max).value;
+	}
+	return TRUE;
+}
@@ -0,0 +1,74 @@
+/* uber-extrema.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_EXTREMA_H__
+#define __UBER_EXTREMA_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct
+{
+	gint64  time;
+	gdouble value;
+} UberExtremaEntry;
+
+typedef struct
+{
+	UberExtremaEntry *entries;
+	guint             len;
+	guint             head;
+	guint             count;
+	gint64            last_time;
+} UberExtremaDeque;
+
+/**
+ * UberExtrema:
+ * @min: Candidates for the minimum, in increasing order of value.
+ * @max: Candidates for the maximum, in decreasing order of value.
+ *
+ * Tracks the minimum and maximum of a sliding window of timestamped
+ * values.  Each value is pushed and expired at most once from each
+ * deque, so maintaining the window costs O(1) amortized per value and
+ * reading the extremes is O(1).
+ *
+ * An #UberExtrema may be embedded in another structure; initialize it with
+ * uber_extrema_init() and release it with uber_extrema_destroy().
+ */
+typedef struct
+{
+	UberExtremaDeque min;
+	UberExtremaDeque max;
+} UberExtrema;
+
+void     uber_extrema_init    (UberExtrema *extrema);
+void     uber_extrema_destroy (UberExtrema *extrema);
+void     uber_extrema_clear   (UberExtrema *extrema);
+void     uber_extrema_push    (UberExtrema *extrema,
+                               gint64       time,
+                               gdouble      value);
+void     uber_extrema_expire  (UberExtrema *extrema,
+                               gint64       before);
+gboolean uber_extrema_get     (UberExtrema *extrema,
+                               gdouble     *min,
+                               gdouble     *max);
+
+G_END_DECLS
+
+#endif /* __UBER_EXTREMA_H__ */
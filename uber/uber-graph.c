@@ -27,9 +27,12 @@
 
 #include "uber-graph.h"
 #include "uber-scale.h"
-#include "uber-frame-source.h"
+#include "uber-layout-cache.h"
+#include "uber-scheduler.h"
 
 #define WIDGET_CLASS (GTK_WIDGET_CLASS(uber_graph_parent_class))
+#define UNFOCUSED_FPS  (5)
+#define LABEL_FONT     "Monospace 6"
 #define RECT_RIGHT(r)  ((r).x + (r).width)
 #define RECT_BOTTOM(r) ((r).y + (r).height)
 #define UNSET_SURFACE(p)       \
@@ -70,10 +73,38 @@
 
 G_DEFINE_ABSTRACT_TYPE(UberGraph, uber_graph, GTK_TYPE_DRAWING_AREA)
 
+/*
+ * The layout and surfaces of the graph for one target.  The graph keeps
+ * one for the widget and one for offscreen rendering; the inactive one is
+ * set aside so switching between them does not lay out or allocate again.
+ */
+typedef struct
+{
+	cairo_surface_t *fg_surface;
+	cairo_surface_t *bg_surface;
+	cairo_surface_t *column_surface;
+	GdkRectangle     content_rect;
+	GdkRectangle     nonvis_rect;
+	gfloat           fps_each;
+	gfloat           dps_each;
+	gint             dps_slot;
+	gboolean         fg_dirty;
+	gboolean         bg_dirty;
+	gboolean         full_draw;
+	gdouble          fps_last_x;
+	gboolean         offscreen;
+	GtkAllocation    offscreen_alloc;
+	guint            serial;        /* layout_serial when set aside. */
+	guint            n_ticks;       /* n_ticks when set aside. */
+} UberGraphLayout;
+
 struct _UberGraphPrivate
 {
 	cairo_surface_t *fg_surface;
 	cairo_surface_t *bg_surface;
+	cairo_surface_t *column_surface; /* One column of the empty content
+	                                  * area, used when flattening.
+	                                  */
 
 	GdkRectangle     content_rect;  /* Content area rectangle. */
 	GdkRectangle     nonvis_rect;   /* Non-visible drawing area larger than
@@ -86,13 +117,20 @@ struct _UberGraphPrivate
 	gboolean         have_rgba;     /* Do we support 32-bit RGBA colormaps. */
 	gint             x_slots;       /* Number of data points on x axis. */
 	gint             fps;           /* Desired frames per second. */
-	gint             fps_real;      /* Milleseconds between FPS callbacks. */
 	gfloat           fps_each;      /* How far to move in each FPS tick. */
 	guint            fps_handler;   /* Timeout for moving the content. */
+	guint            tick_handler;  /* Frame clock callback, if synced. */
+	gboolean         sync_to_frame_clock; /* Pace frames by the frame clock. */
+	gint64           frame_time;    /* Frame clock time of this frame. */
+	GtkWidget       *toplevel;      /* Toplevel watched for visibility. */
+	gboolean         iconified;     /* Is the toplevel minimized. */
+	gboolean         obscured;      /* Is the toplevel fully covered. */
+	gboolean         unfocused;     /* Is the toplevel inactive. */
+	guint            idle_ticks;    /* Data ticks in a row without data. */
 	gfloat           dps;           /* Desired data points per second. */
 	gint             dps_slot;      /* Which slot in the surface buffer. */
 	gfloat           dps_each;      /* How many pixels between data points. */
-	GTimeVal         dps_tv;        /* Timeval of last data point. */
+	gint64           dps_time;      /* Monotonic time of last data point. */
 	guint            dps_handler;   /* Timeout for getting new data. */
 	guint            dps_downscale; /* Count since last downscale. */
 	gboolean         fg_dirty;      /* Does the foreground need to be redrawn. */
@@ -108,10 +146,23 @@ struct _UberGraphPrivate
 	GtkWidget       *labels;        /* Container for graph labels. */
 	GtkWidget       *align;         /* Alignment for labels. */
 	gint             fps_count;     /* Track actual FPS. */
+	gdouble          fps_last_x;    /* Ring position of the last frame. */
+	gboolean         smooth_scroll; /* Scroll by fractions of a pixel. */
+	gboolean         offscreen;     /* Rendering to image surfaces. */
+	GtkAllocation    offscreen_alloc; /* Size when rendering offscreen. */
+	UberGraphLayout  inactive;      /* Layout of the other target. */
+	guint            layout_serial; /* Bumped when the geometry changes. */
+	guint            n_ticks;       /* Data ticks so far. */
+	gboolean         flatten;       /* Keep the foreground opaque. */
 };
 
 static gboolean show_fps = FALSE;
 
+static gdouble uber_graph_get_ring_x        (UberGraph *graph);
+static void uber_graph_invalidate_inactive  (UberGraph *graph);
+static void uber_graph_init_texture         (UberGraph *graph);
+static void uber_graph_register_fps_handler (UberGraph *graph);
+
 enum
 {
 	PROP_0,
@@ -139,7 +190,8 @@ uber_graph_new (void)
  * uber_graph_fps_timeout:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Invalidates the content area when the next frame would differ from the
+ * one on screen.
  *
  * Returns: %TRUE always.
  * Side effects: None.
@@ -152,6 +204,16 @@ uber_graph_fps_timeout (UberGraph *graph) /* IN */
 	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
 
 	priv = graph->priv;
+	/*
+	 * Nothing moves while paused, and there is nothing to repaint if the
+	 * content would land on the same pixels as the last frame.
+	 */
+	if (priv->paused) {
+		return TRUE;
+	}
+	if (!priv->fg_dirty && uber_graph_get_ring_x(graph) == priv->fps_last_x) {
+		return TRUE;
+	}
 	gtk_widget_queue_draw_area(GTK_WIDGET(graph),
 	                           priv->content_rect.x,
 	                           priv->content_rect.y,
@@ -223,6 +285,7 @@ uber_graph_set_show_xlines (UberGraph *graph,       /* IN */
 	priv = graph->priv;
 	priv->show_xlines = show_xlines;
 	priv->bg_dirty = TRUE;
+	priv->inactive.bg_dirty = TRUE;
 	gtk_widget_queue_draw(GTK_WIDGET(graph));
 }
 
@@ -267,6 +330,111 @@ uber_graph_set_show_ylines (UberGraph *graph,       /* IN */
 	priv = graph->priv;
 	priv->show_ylines = show_ylines;
 	priv->bg_dirty = TRUE;
+	priv->inactive.bg_dirty = TRUE;
+	gtk_widget_queue_draw(GTK_WIDGET(graph));
+}
+
+/**
+ * uber_graph_get_flatten:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves if the foreground is kept flattened onto the background.
+ *
+ * Returns: %TRUE if the graph is flattened.
+ * Side effects: None.
+ */
+gboolean
+uber_graph_get_flatten (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
+	return graph->priv->flatten;
+}
+
+/**
+ * uber_graph_set_flatten:
+ * @graph: A #UberGraph.
+ * @flatten: If the foreground should be flattened.
+ *
+ * Sets if new foreground content is rendered onto an opaque copy of the
+ * content background rather than onto a transparent surface.  Each frame
+ * is then a plain copy of the two foreground ring segments instead of an
+ * alpha blend over the background, which costs much less fill rate where
+ * drawing is done in software, such as over remote X or VNC.
+ *
+ * Vertical grid lines are not shown inside the content area while
+ * flattened, and horizontal grid lines are drawn solid rather than dashed.
+ * New content is laid over copies of a single column of the empty content
+ * area, which cannot carry a dash pattern along the line.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_flatten (UberGraph *graph,   /* IN */
+                        gboolean   flatten) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	flatten = !!flatten;
+	if (priv->flatten == flatten) {
+		return;
+	}
+	priv->flatten = flatten;
+	/*
+	 * The foreground surface changes content type.
+	 */
+	if (priv->fg_surface) {
+		UNSET_SURFACE(priv->fg_surface);
+		uber_graph_init_texture(graph);
+	}
+	uber_graph_redraw(graph);
+}
+
+/**
+ * uber_graph_get_smooth_scroll:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves if the content scrolls by fractions of a pixel.
+ *
+ * Returns: %TRUE if scrolling smoothly.
+ * Side effects: None.
+ */
+gboolean
+uber_graph_get_smooth_scroll (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
+	return graph->priv->smooth_scroll;
+}
+
+/**
+ * uber_graph_set_smooth_scroll:
+ * @graph: A #UberGraph.
+ * @smooth_scroll: If the content should scroll by fractions of a pixel.
+ *
+ * Sets if the content is moved by fractions of a pixel, filtering the
+ * foreground between pixels, so that motion stays even when the data rate
+ * does not divide into whole pixels per frame.  Otherwise the content is
+ * snapped to whole pixels and a frame is only drawn when it moves.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_smooth_scroll (UberGraph *graph,         /* IN */
+                              gboolean   smooth_scroll) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	priv->smooth_scroll = !!smooth_scroll;
+	if (priv->fps_handler || priv->tick_handler) {
+		uber_graph_register_fps_handler(graph);
+	}
 	gtk_widget_queue_draw(GTK_WIDGET(graph));
 }
 
@@ -304,22 +472,34 @@ uber_graph_scale_changed (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
+	cairo_region_t *region;
+	GdkWindow *window;
 	GdkRectangle rect;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	priv = graph->priv;
+	uber_graph_invalidate_inactive(graph);
 	if (!priv->paused) {
 		priv->fg_dirty = TRUE;
 		priv->bg_dirty = TRUE;
 		priv->full_draw = TRUE;
+		if (!(window = gtk_widget_get_window(GTK_WIDGET(graph)))) {
+			return;
+		}
+		/*
+		 * Only the Y axis labels and the content depend on the scale, so
+		 * damage the label gutter and the content area and nothing else.
+		 */
 		gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
 		rect.x = 0;
 		rect.y = 0;
-		rect.width = alloc.width;
+		rect.width = priv->content_rect.x;
 		rect.height = alloc.height;
-		gdk_window_invalidate_rect(gtk_widget_get_window(GTK_WIDGET(graph)),
-		                           &rect, TRUE);
+		region = cairo_region_create_rectangle(&rect);
+		cairo_region_union_rectangle(region, &priv->content_rect);
+		gdk_window_invalidate_region(window, region, TRUE);
+		cairo_region_destroy(region);
 	}
 }
 
@@ -342,10 +522,11 @@ uber_graph_get_next_data (UberGraph *graph) /* IN */
 
 	/*
 	 * Get the current time for this data point.  This is used to calculate
-	 * the proper offset in the FPS callback.
+	 * the proper offset in the FPS callback and is the time at the right
+	 * edge of the newest slot, which renderers place samples against.
 	 */
 	priv = graph->priv;
-	g_get_current_time(&priv->dps_tv);
+	priv->dps_time = g_get_monotonic_time();
 	/*
 	 * Notify the subclass to retrieve the data point.
 	 */
@@ -355,6 +536,62 @@ uber_graph_get_next_data (UberGraph *graph) /* IN */
 	return ret;
 }
 
+/**
+ * uber_graph_get_allocation:
+ * @graph: A #UberGraph.
+ * @alloc: (out): A location for the allocation.
+ *
+ * Retrieves the area the graph is laid out in.  This is the widget
+ * allocation, or the size of the target when rendering offscreen.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_get_allocation (UberGraph     *graph, /* IN */
+                           GtkAllocation *alloc) /* OUT */
+{
+	if (graph->priv->offscreen) {
+		*alloc = graph->priv->offscreen_alloc;
+	} else {
+		gtk_widget_get_allocation(GTK_WIDGET(graph), alloc);
+	}
+}
+
+/**
+ * uber_graph_create_surface:
+ * @graph: A #UberGraph.
+ * @content: The #cairo_content_t of the surface.
+ * @width: The width of the surface.
+ * @height: The height of the surface.
+ *
+ * Creates a surface to render parts of the graph into.  Image surfaces are
+ * used when rendering offscreen, otherwise the surface is similar to the
+ * widget's #GdkWindow.
+ *
+ * Returns: A new surface, or %NULL if the widget has no #GdkWindow.
+ * Side effects: None.
+ */
+static cairo_surface_t*
+uber_graph_create_surface (UberGraph       *graph,   /* IN */
+                           cairo_content_t  content, /* IN */
+                           gint             width,   /* IN */
+                           gint             height)  /* IN */
+{
+	GdkWindow *window;
+
+	if (graph->priv->offscreen) {
+		return cairo_image_surface_create((content == CAIRO_CONTENT_COLOR) ?
+		                                  CAIRO_FORMAT_RGB24 :
+		                                  CAIRO_FORMAT_ARGB32,
+		                                  width, height);
+	}
+	if (!(window = gtk_widget_get_window(GTK_WIDGET(graph)))) {
+		return NULL;
+	}
+	return gdk_window_create_similar_surface(window, content, width, height);
+}
+
 /**
  * uber_graph_init_texture:
  * @graph: A #UberGraph.
@@ -369,27 +606,26 @@ uber_graph_init_texture (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
-	GdkWindow *window;
 	cairo_t *cr;
 	gint width;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	priv = graph->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
-	window = gtk_widget_get_window(GTK_WIDGET(graph));
+	uber_graph_get_allocation(graph, &alloc);
 	/*
-	 * Get drawable to base surface upon.
+	 * Initialize foreground and background surface.
 	 */
-	if (!window) {
+	width = MAX(priv->nonvis_rect.x + priv->nonvis_rect.width, alloc.width);
+	priv->fg_surface = uber_graph_create_surface(graph,
+	                                             priv->flatten ?
+	                                             CAIRO_CONTENT_COLOR :
+	                                             CAIRO_CONTENT_COLOR_ALPHA,
+	                                             width, alloc.height);
+	if (!priv->fg_surface) {
 		g_critical("%s() called before GdkWindow is allocated.", G_STRFUNC);
 		return;
 	}
-	/*
-	 * Initialize foreground and background surface.
-	 */
-	width = MAX(priv->nonvis_rect.x + priv->nonvis_rect.width, alloc.width);
-	priv->fg_surface = gdk_window_create_similar_surface(window, CAIRO_CONTENT_COLOR_ALPHA, width, alloc.height);
 	/*
 	 * Clear foreground contents.
 	 */
@@ -412,25 +648,22 @@ uber_graph_init_bg (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
-	GdkWindow *window;
 	cairo_t *cr;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	priv = graph->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
-	window = gtk_widget_get_window(GTK_WIDGET(graph));
+	uber_graph_get_allocation(graph, &alloc);
 	/*
-	 * Get drawable for surface.
+	 * Create the server-side surface.
 	 */
-	if (!window) {
+	priv->bg_surface = uber_graph_create_surface(graph,
+	                                             CAIRO_CONTENT_COLOR_ALPHA,
+	                                             alloc.width, alloc.height);
+	if (!priv->bg_surface) {
 		g_critical("%s() called before GdkWindow is allocated.", G_STRFUNC);
 		return;
 	}
-	/*
-	 * Create the server-side surface.
-	 */
-	priv->bg_surface = gdk_window_create_similar_surface(window, CAIRO_CONTENT_COLOR_ALPHA, alloc.width, alloc.height);
 	/*
 	 * Clear background contents.
 	 */
@@ -453,38 +686,27 @@ uber_graph_calculate_rects (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
-	PangoLayout *layout;
-	PangoFontDescription *font_desc;
 	GdkWindow *window;
 	gint pango_width;
 	gint pango_height;
-	cairo_t *cr;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	priv = graph->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
+	uber_graph_get_allocation(graph, &alloc);
 	window = gtk_widget_get_window(GTK_WIDGET(graph));
 	/*
-	 * We can't calculate rectangles before we have a GdkWindow.
+	 * We can't calculate rectangles before we have a GdkWindow, unless
+	 * rendering offscreen.
 	 */
-	if (!window) {
+	if (!window && !priv->offscreen) {
 		return;
 	}
 	/*
 	 * Determine the pixels required for labels.
 	 */
-	cr = gdk_cairo_create(window);
-	layout = pango_cairo_create_layout(cr);
-	font_desc = pango_font_description_new();
-	pango_font_description_set_family_static(font_desc, "Monospace");
-	pango_font_description_set_size(font_desc, 6 * PANGO_SCALE);
-	pango_layout_set_font_description(layout, font_desc);
-	pango_layout_set_text(layout, "XXXXXXXXXX", -1);
-	pango_layout_get_pixel_size(layout, &pango_width, &pango_height);
-	pango_font_description_free(font_desc);
-	g_object_unref(layout);
-	cairo_destroy(cr);
+	uber_layout_cache_lookup(LABEL_FONT, "XXXXXXXXXX",
+	                         &pango_width, &pango_height);
 	/*
 	 * Calculate content area rectangle.
 	 */
@@ -507,22 +729,11 @@ uber_graph_calculate_rects (UberGraph *graph) /* IN */
 	priv->fps_each = priv->dps_each
 	               / ((gfloat)priv->fps / (gfloat)priv->dps);
 	/*
-	 * XXX: Small hack to make things a bit smoother at small scales.
+	 * Update FPS callback.  Frame pacing follows the widget, not offscreen
+	 * renders.
 	 */
-	if (priv->fps_each < .5) {
-		priv->fps_each = 1;
-		priv->fps_real = (1000. / priv->dps_each) / 2.;
-	} else {
-		priv->fps_real = 1000. / priv->fps;
-	}
-	/*
-	 * Update FPS callback.
-	 */
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-		priv->fps_handler = uber_frame_source_add(priv->fps,
-		                                  (GSourceFunc)uber_graph_fps_timeout,
-		                                  graph);
+	if (priv->fps_handler && !priv->offscreen) {
+		uber_graph_register_fps_handler(graph);
 	}
 	/*
 	 * Calculate the non-visible area that drawing should happen within.
@@ -532,12 +743,119 @@ uber_graph_calculate_rects (UberGraph *graph) /* IN */
 	/*
 	 * Update positioning for label alignment.
 	 */
+	if (priv->offscreen) {
+		return;
+	}
 	gtk_widget_set_margin_top(GTK_WIDGET(priv->align), 6);
 	gtk_widget_set_margin_bottom(GTK_WIDGET(priv->align), 6);
 	gtk_widget_set_margin_start(GTK_WIDGET(priv->align), priv->content_rect.x);
 	gtk_widget_set_margin_end(GTK_WIDGET(priv->align), 0);
 }
 
+/**
+ * uber_graph_reset_surfaces:
+ * @graph: A #UberGraph.
+ *
+ * Lays the graph out for its current size and recreates the surfaces that
+ * are rendered into.  Everything is drawn again on the next frame.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_reset_surfaces (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	priv = graph->priv;
+	uber_graph_calculate_rects(graph);
+	UNSET_SURFACE(priv->bg_surface);
+	UNSET_SURFACE(priv->fg_surface);
+	UNSET_SURFACE(priv->column_surface);
+	uber_graph_init_bg(graph);
+	uber_graph_init_texture(graph);
+	priv->fg_dirty = TRUE;
+	priv->bg_dirty = TRUE;
+	priv->full_draw = TRUE;
+}
+
+/**
+ * uber_graph_swap_layout:
+ * @graph: A #UberGraph.
+ *
+ * Sets the current layout aside and makes the one set aside current.  A
+ * layout that missed data ticks while set aside has its foreground redrawn.
+ * One that missed a change to the layout itself must be laid out again.
+ *
+ * Returns: %TRUE if the layout now current must be laid out again.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_swap_layout (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	UberGraphLayout layout;
+
+	priv = graph->priv;
+	layout = priv->inactive;
+
+#define SWAP_FIELD(f) G_STMT_START { \
+	priv->inactive.f = priv->f;      \
+	priv->f = layout.f;              \
+} G_STMT_END
+
+	SWAP_FIELD(fg_surface);
+	SWAP_FIELD(bg_surface);
+	SWAP_FIELD(column_surface);
+	SWAP_FIELD(content_rect);
+	SWAP_FIELD(nonvis_rect);
+	SWAP_FIELD(fps_each);
+	SWAP_FIELD(dps_each);
+	SWAP_FIELD(dps_slot);
+	SWAP_FIELD(fg_dirty);
+	SWAP_FIELD(bg_dirty);
+	SWAP_FIELD(full_draw);
+	SWAP_FIELD(fps_last_x);
+	SWAP_FIELD(offscreen);
+	SWAP_FIELD(offscreen_alloc);
+
+#undef SWAP_FIELD
+
+	priv->inactive.serial = priv->layout_serial;
+	priv->inactive.n_ticks = priv->n_ticks;
+	if (!priv->fg_surface || !priv->bg_surface ||
+	    layout.serial != priv->layout_serial) {
+		return TRUE;
+	}
+	if (layout.n_ticks != priv->n_ticks) {
+		priv->fg_dirty = TRUE;
+		priv->full_draw = TRUE;
+	}
+	return FALSE;
+}
+
+/**
+ * uber_graph_invalidate_inactive:
+ * @graph: A #UberGraph.
+ *
+ * Marks the content of the layout set aside as needing to be drawn again.
+ * Its geometry and surfaces are kept, so switching to it does not lay out
+ * or allocate again.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_invalidate_inactive (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	priv = graph->priv;
+	priv->inactive.fg_dirty = TRUE;
+	priv->inactive.bg_dirty = TRUE;
+	priv->inactive.full_draw = TRUE;
+}
+
 /**
  * uber_graph_get_show_xlabels:
  * @graph: A #UberGraph.
@@ -579,10 +897,27 @@ uber_graph_set_show_xlabels (UberGraph *graph,       /* IN */
 	priv = graph->priv;
 	priv->show_xlabels = show_xlabels;
 	priv->bg_dirty = TRUE;
+	priv->layout_serial++;
 	uber_graph_calculate_rects(graph);
 	gtk_widget_queue_draw(GTK_WIDGET(graph));
 }
 
+/**
+ * uber_graph_is_idle:
+ * @graph: A #UberGraph.
+ *
+ * Checks if no data has arrived for as long as it takes for a data point
+ * to cross the content area.
+ *
+ * Returns: %TRUE if the content is empty and not moving.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_graph_is_idle (UberGraph *graph) /* IN */
+{
+	return graph->priv->idle_ticks >= graph->priv->x_slots;
+}
+
 /**
  * uber_graph_dps_timeout:
  * @graph: A #UberGraph.
@@ -596,14 +931,28 @@ static gboolean
 uber_graph_dps_timeout (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
+	gboolean idle;
 
 	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
 
 	priv = graph->priv;
-	if (!uber_graph_get_next_data(graph)) {
-		/*
-		 * XXX: How should we handle failed data retrieval.
-		 */
+	/*
+	 * Once a full width of ticks has passed without data the content is
+	 * empty and there is nothing left to scroll, so frames are stopped
+	 * until data arrives again.
+	 */
+	priv->n_ticks++;
+	if (uber_graph_get_next_data(graph)) {
+		idle = uber_graph_is_idle(graph);
+		priv->idle_ticks = 0;
+		if (idle) {
+			uber_graph_register_fps_handler(graph);
+		}
+	} else if (priv->idle_ticks < priv->x_slots) {
+		priv->idle_ticks++;
+		if (uber_graph_is_idle(graph)) {
+			uber_graph_register_fps_handler(graph);
+		}
 	}
 	if (G_UNLIKELY(show_fps)) {
 		g_print("UberGraph[%p] %02d FPS\n", graph, priv->fps_count);
@@ -613,6 +962,13 @@ uber_graph_dps_timeout (UberGraph *graph) /* IN */
 	 * Make sure the content is re-rendered.
 	 */
 	if (!priv->paused) {
+		/*
+		 * Only one new slot is rendered per frame, so if the last data
+		 * point was never drawn the whole foreground must be.
+		 */
+		if (priv->fg_dirty) {
+			priv->full_draw = TRUE;
+		}
 		priv->fg_dirty = TRUE;
 		/*
 		 * We do not queue a draw here since the next FPS callback will happen
@@ -650,26 +1006,22 @@ static void
 uber_graph_register_dps_handler (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
-	guint dps_freq;
 	gboolean do_now = TRUE;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	priv = graph->priv;
 	if (priv->dps_handler) {
-		g_source_remove(priv->dps_handler);
+		uber_scheduler_remove(priv->dps_handler);
 		do_now = FALSE;
 	}
 	/*
-	 * Calculate the update frequency.
+	 * Install the data handler.  Graphs sharing a data rate are updated
+	 * together from one wakeup.
 	 */
-	dps_freq = 1000 / priv->dps;
-	/*
-	 * Install the data handler.
-	 */
-	priv->dps_handler = g_timeout_add(dps_freq,
-	                                  (GSourceFunc)uber_graph_dps_timeout,
-	                                  graph);
+	priv->dps_handler = uber_scheduler_add(G_USEC_PER_SEC / priv->dps,
+	                                       (GSourceFunc)uber_graph_dps_timeout,
+	                                       graph);
 	/*
 	 * Call immediately.
 	 */
@@ -679,89 +1031,380 @@ uber_graph_register_dps_handler (UberGraph *graph) /* IN */
 }
 
 /**
- * uber_graph_register_fps_handler:
+ * uber_graph_unregister_fps_handler:
+ * @graph: A #UberGraph.
+ *
+ * Stops moving the content, whichever way frames are being paced.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_unregister_fps_handler (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	priv = graph->priv;
+	if (priv->fps_handler) {
+		uber_scheduler_remove(priv->fps_handler);
+		priv->fps_handler = 0;
+	}
+	if (priv->tick_handler) {
+		gtk_widget_remove_tick_callback(GTK_WIDGET(graph), priv->tick_handler);
+		priv->tick_handler = 0;
+	}
+	priv->frame_time = 0;
+}
+
+/**
+ * uber_graph_tick:
+ * @widget: A #GtkWidget.
+ * @frame_clock: The #GdkFrameClock of @widget.
+ * @user_data: Unused.
+ *
+ * Frame clock callback used in place of the FPS timeout when the graph is
+ * synced to the frame clock.  The frame time is kept so that the content
+ * offset matches the time the frame will be presented.
+ *
+ * Returns: %TRUE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_tick (GtkWidget     *widget,      /* IN */
+                 GdkFrameClock *frame_clock, /* IN */
+                 gpointer       user_data)   /* IN */
+{
+	UberGraphPrivate *priv;
+
+	priv = UBER_GRAPH(widget)->priv;
+	priv->frame_time = gdk_frame_clock_get_frame_time(frame_clock);
+	uber_graph_fps_timeout(UBER_GRAPH(widget));
+	return TRUE;
+}
+
+/**
+ * uber_graph_get_frame_rate:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves the rate at which frames are actually produced.  This is the
+ * requested frames per second, throttled while the toplevel is inactive
+ * to no less than one frame per data point.
+ * Unless scrolling smoothly, it is also limited so that each frame moves
+ * the content at least one pixel.
+ *
+ * Returns: The frames per second, or 0 if no frames are needed.
+ * Side effects: None.
+ */
+static guint
+uber_graph_get_frame_rate (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	gfloat pps;
+	guint fps;
+
+	priv = graph->priv;
+	fps = priv->fps;
+	if (priv->unfocused) {
+		fps = MIN(fps, MAX(UNFOCUSED_FPS, (guint)ceil(priv->dps)));
+	}
+	/*
+	 * Frames beyond one per pixel of movement would repaint the content
+	 * at the same position.
+	 */
+	pps = priv->dps_each * priv->dps;
+	if (!priv->smooth_scroll && pps > 0.) {
+		fps = MIN(fps, MAX(1, (guint)ceil(pps)));
+	}
+	return fps;
+}
+
+/**
+ * uber_graph_register_fps_handler:
+ * @graph: A #UberGraph.
+ *
+ * XXX
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_register_fps_handler (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	guint fps;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	/*
+	 * Remove any existing FPS handler.
+	 */
+	uber_graph_unregister_fps_handler(graph);
+	/*
+	 * Nothing changes on screen while paused or idle, and nobody can see
+	 * the graph while it is hidden or its toplevel is minimized or covered.
+	 */
+	if (priv->paused || priv->iconified || priv->obscured ||
+	    uber_graph_is_idle(graph) ||
+	    !gtk_widget_get_visible(GTK_WIDGET(graph))) {
+		return;
+	}
+	fps = uber_graph_get_frame_rate(graph);
+	if (!fps) {
+		return;
+	}
+	/*
+	 * Install the FPS timeout, or follow the frame clock if requested.  The
+	 * frame clock cannot be slowed down, so it is only followed at the full
+	 * requested rate.
+	 */
+	if (priv->sync_to_frame_clock && fps == priv->fps) {
+		priv->tick_handler =
+			gtk_widget_add_tick_callback(GTK_WIDGET(graph),
+			                             uber_graph_tick, NULL, NULL);
+	} else {
+		priv->fps_handler = uber_scheduler_add(G_USEC_PER_SEC / fps,
+		                                  (GSourceFunc)uber_graph_fps_timeout,
+		                                  graph);
+	}
+}
+
+/**
+ * uber_graph_set_dps:
+ * @graph: A #UberGraph.
+ *
+ * XXX
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_dps (UberGraph *graph, /* IN */
+                    gfloat     dps)   /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	priv->dps = dps;
+	/*
+	 * TODO: Does this belong somewhere else?
+	 */
+	if (UBER_GRAPH_GET_CLASS(graph)->set_stride) {
+		UBER_GRAPH_GET_CLASS(graph)->set_stride(graph, priv->x_slots);
+	}
+	/*
+	 * Recalculate frame rates and timeouts.
+	 */
+	priv->layout_serial++;
+	uber_graph_calculate_rects(graph);
+	uber_graph_register_dps_handler(graph);
+	uber_graph_register_fps_handler(graph);
+}
+
+/**
+ * uber_graph_set_fps:
+ * @graph: A #UberGraph.
+ *
+ * XXX
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_fps (UberGraph *graph, /* IN */
+                    guint      fps)   /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	priv->fps = fps;
+	uber_graph_register_fps_handler(graph);
+}
+
+/**
+ * uber_graph_get_sync_to_frame_clock:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves if frames are paced by the frame clock.
+ *
+ * Returns: %TRUE if frames follow the frame clock.
+ * Side effects: None.
+ */
+gboolean
+uber_graph_get_sync_to_frame_clock (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), FALSE);
+	return graph->priv->sync_to_frame_clock;
+}
+
+/**
+ * uber_graph_set_sync_to_frame_clock:
+ * @graph: A #UberGraph.
+ * @sync_to_frame_clock: If frames should follow the frame clock.
+ *
+ * Sets if the content is moved on every tick of the widget's
+ * #GdkFrameClock instead of by a timer at the requested frames per second.
+ * Frames are then in step with the display refresh, and the content is
+ * placed for the time the frame is presented, which avoids judder.  The
+ * rate set with uber_graph_set_fps() is not used while synced.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_set_sync_to_frame_clock (UberGraph *graph,               /* IN */
+                                    gboolean   sync_to_frame_clock) /* IN */
+{
+	UberGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+
+	priv = graph->priv;
+	priv->sync_to_frame_clock = !!sync_to_frame_clock;
+	if (priv->fps_handler || priv->tick_handler) {
+		uber_graph_register_fps_handler(graph);
+	}
+}
+
+/**
+ * uber_graph_get_dps:
+ * @graph: A #UberGraph.
+ *
+ * Retrieves the number of data points per second.  Each data point is
+ * given the same width on the x axis, so renderers use this to convert
+ * between time and pixels.
+ *
+ * Returns: The data points per second.
+ * Side effects: None.
+ */
+gfloat
+uber_graph_get_dps (UberGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0.);
+	return graph->priv->dps;
+}
+
+/**
+ * uber_graph_get_data_time:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Retrieves the monotonic time, in microseconds, of the most recent data
+ * point.  The epoch passed to the render methods is the x position of this
+ * time; a sample taken at time t belongs at
+ * epoch - ((data_time - t) * each * dps / %G_USEC_PER_SEC).
  *
- * Returns: None.
+ * Returns: The time of the last data point.
  * Side effects: None.
  */
-static void
-uber_graph_register_fps_handler (UberGraph *graph) /* IN */
+gint64
+uber_graph_get_data_time (UberGraph *graph) /* IN */
 {
-	UberGraphPrivate *priv;
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0);
+	return graph->priv->dps_time;
+}
 
-	g_return_if_fail(UBER_IS_GRAPH(graph));
+/**
+ * uber_graph_toplevel_window_state:
+ * @toplevel: The toplevel #GtkWidget.
+ * @event: A #GdkEventWindowState.
+ * @graph: A #UberGraph.
+ *
+ * Stops moving the content while the toplevel is minimized and slows it
+ * down while the toplevel does not have focus.
+ *
+ * Returns: %FALSE always.
+ * Side effects: None.
+ */
+static gboolean
+uber_graph_toplevel_window_state (GtkWidget           *toplevel, /* IN */
+                                  GdkEventWindowState *event,    /* IN */
+                                  UberGraph           *graph)    /* IN */
+{
+	UberGraphPrivate *priv;
+	gboolean iconified;
+	gboolean unfocused;
 
 	priv = graph->priv;
-	/*
-	 * Remove any existing FPS handler.
-	 */
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
+	iconified = !!(event->new_window_state & GDK_WINDOW_STATE_ICONIFIED);
+	unfocused = !(event->new_window_state & GDK_WINDOW_STATE_FOCUSED);
+	if (iconified != priv->iconified || unfocused != priv->unfocused) {
+		priv->iconified = iconified;
+		priv->unfocused = unfocused;
+		uber_graph_register_fps_handler(graph);
 	}
-	/*
-	 * Install the FPS timeout.
-	 */
-	priv->fps_handler = uber_frame_source_add(priv->fps,
-	                                  (GSourceFunc)uber_graph_fps_timeout,
-	                                  graph);
+	return FALSE;
 }
 
 /**
- * uber_graph_set_dps:
+ * uber_graph_toplevel_visibility:
+ * @toplevel: The toplevel #GtkWidget.
+ * @event: A #GdkEventVisibility.
  * @graph: A #UberGraph.
  *
- * XXX
+ * Stops moving the content while the toplevel is completely covered by
+ * other windows.
  *
- * Returns: None.
+ * Returns: %FALSE always.
  * Side effects: None.
  */
-void
-uber_graph_set_dps (UberGraph *graph, /* IN */
-                    gfloat     dps)   /* IN */
+static gboolean
+uber_graph_toplevel_visibility (GtkWidget          *toplevel, /* IN */
+                                GdkEventVisibility *event,    /* IN */
+                                UberGraph          *graph)    /* IN */
 {
 	UberGraphPrivate *priv;
-
-	g_return_if_fail(UBER_IS_GRAPH(graph));
+	gboolean obscured;
 
 	priv = graph->priv;
-	priv->dps = dps;
-	/*
-	 * TODO: Does this belong somewhere else?
-	 */
-	if (UBER_GRAPH_GET_CLASS(graph)->set_stride) {
-		UBER_GRAPH_GET_CLASS(graph)->set_stride(graph, priv->x_slots);
+	obscured = (event->state == GDK_VISIBILITY_FULLY_OBSCURED);
+	if (obscured != priv->obscured) {
+		priv->obscured = obscured;
+		uber_graph_register_fps_handler(graph);
 	}
-	/*
-	 * Recalculate frame rates and timeouts.
-	 */
-	uber_graph_calculate_rects(graph);
-	uber_graph_register_dps_handler(graph);
-	uber_graph_register_fps_handler(graph);
+	return FALSE;
 }
 
 /**
- * uber_graph_set_fps:
+ * uber_graph_watch_toplevel:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Follows the state of the toplevel window containing @graph so frames
+ * are only produced while they can be seen.
  *
  * Returns: None.
  * Side effects: None.
  */
-void
-uber_graph_set_fps (UberGraph *graph, /* IN */
-                    guint      fps)   /* IN */
+static void
+uber_graph_watch_toplevel (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
-
-	g_return_if_fail(UBER_IS_GRAPH(graph));
+	GtkWidget *toplevel;
 
 	priv = graph->priv;
-	priv->fps = fps;
-	uber_graph_register_fps_handler(graph);
+	toplevel = gtk_widget_get_toplevel(GTK_WIDGET(graph));
+	if (!GTK_IS_WINDOW(toplevel) || toplevel == priv->toplevel) {
+		return;
+	}
+	if (priv->toplevel) {
+		g_signal_handlers_disconnect_by_data(priv->toplevel, graph);
+		g_object_remove_weak_pointer(G_OBJECT(priv->toplevel),
+		                             (gpointer *)&priv->toplevel);
+	}
+	priv->toplevel = toplevel;
+	priv->iconified = FALSE;
+	priv->obscured = FALSE;
+	g_object_add_weak_pointer(G_OBJECT(toplevel), (gpointer *)&priv->toplevel);
+	gtk_widget_add_events(toplevel, GDK_VISIBILITY_NOTIFY_MASK);
+	g_signal_connect_object(toplevel, "window-state-event",
+	                        G_CALLBACK(uber_graph_toplevel_window_state),
+	                        graph, 0);
+	g_signal_connect_object(toplevel, "visibility-notify-event",
+	                        G_CALLBACK(uber_graph_toplevel_visibility),
+	                        graph, 0);
 }
 
 /**
@@ -785,14 +1428,20 @@ uber_graph_realize (GtkWidget *widget) /* IN */
 	priv = graph->priv;
 	WIDGET_CLASS->realize(widget);
 	/*
-	 * Calculate new layout based on allocation.
+	 * Set aside any layout used for offscreen rendering, then calculate a
+	 * new layout based on allocation.
 	 */
+	if (priv->offscreen) {
+		uber_graph_swap_layout(graph);
+		priv->offscreen = FALSE;
+	}
 	uber_graph_calculate_rects(graph);
 	/*
 	 * Re-initialize textures for updated sizes.
 	 */
 	UNSET_SURFACE(priv->bg_surface);
 	UNSET_SURFACE(priv->fg_surface);
+	UNSET_SURFACE(priv->column_surface);
 	uber_graph_init_bg(graph);
 	uber_graph_init_texture(graph);
 	/*
@@ -806,6 +1455,10 @@ uber_graph_realize (GtkWidget *widget) /* IN */
 	 * Install the data collector.
 	 */
 	uber_graph_register_dps_handler(graph);
+	/*
+	 * Stop drawing when the window cannot be seen.
+	 */
+	uber_graph_watch_toplevel(graph);
 }
 
 /**
@@ -831,14 +1484,21 @@ uber_graph_unrealize (GtkWidget *widget) /* IN */
 	 * Unregister any data acquisition handlers.
 	 */
 	if (priv->dps_handler) {
-		g_source_remove(priv->dps_handler);
+		uber_scheduler_remove(priv->dps_handler);
 		priv->dps_handler = 0;
 	}
 	/*
-	 * Destroy textures.
+	 * Destroy textures.  Those of an offscreen layout set aside are image
+	 * surfaces and are kept.
 	 */
 	UNSET_SURFACE(priv->bg_surface);
 	UNSET_SURFACE(priv->fg_surface);
+	UNSET_SURFACE(priv->column_surface);
+	if (!priv->inactive.offscreen) {
+		UNSET_SURFACE(priv->inactive.bg_surface);
+		UNSET_SURFACE(priv->inactive.fg_surface);
+		UNSET_SURFACE(priv->inactive.column_surface);
+	}
 }
 
 /**
@@ -903,18 +1563,12 @@ uber_graph_show (GtkWidget *widget) /* IN */
 static void
 uber_graph_hide (GtkWidget *widget) /* IN */
 {
-	UberGraphPrivate *priv;
-
 	g_return_if_fail(UBER_IS_GRAPH(widget));
 
-	priv = UBER_GRAPH(widget)->priv;
 	/*
 	 * Disable the FPS timeout when we are not visible.
 	 */
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-		priv->fps_handler = 0;
-	}
+	uber_graph_unregister_fps_handler(UBER_GRAPH(widget));
 }
 
 static inline void
@@ -927,7 +1581,7 @@ uber_graph_get_pixmap_rect (UberGraph    *graph, /* IN */
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
 	priv = graph->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
+	uber_graph_get_allocation(graph, &alloc);
 	rect->x = 0;
 	rect->y = 0;
 	rect->width = MAX(alloc.width,
@@ -935,6 +1589,43 @@ uber_graph_get_pixmap_rect (UberGraph    *graph, /* IN */
 	rect->height = alloc.height;
 }
 
+/**
+ * uber_graph_clear_fg:
+ * @graph: A #UberGraph.
+ * @cr: A #cairo_t for the foreground surface.
+ * @rect: The area to clear.
+ *
+ * Clears part of the foreground before new content is rendered into it.
+ * When flattening, the empty content area is painted instead, so the
+ * foreground stays opaque and can be copied straight to the window.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_graph_clear_fg (UberGraph    *graph, /* IN */
+                     cairo_t      *cr,    /* IN */
+                     GdkRectangle *rect)  /* IN */
+{
+	UberGraphPrivate *priv;
+	cairo_pattern_t *pattern;
+
+	priv = graph->priv;
+	cairo_save(cr);
+	if (priv->flatten && priv->column_surface) {
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		pattern = cairo_pattern_create_for_surface(priv->column_surface);
+		cairo_pattern_set_extend(pattern, CAIRO_EXTEND_REPEAT);
+		cairo_set_source(cr, pattern);
+		cairo_pattern_destroy(pattern);
+	} else {
+		cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+	}
+	gdk_cairo_rectangle(cr, rect);
+	cairo_fill(cr);
+	cairo_restore(cr);
+}
+
 /**
  * uber_graph_render_fg:
  * @graph: A #UberGraph.
@@ -960,7 +1651,7 @@ uber_graph_render_fg (UberGraph *graph) /* IN */
 	 * Acquire resources.
 	 */
 	priv = graph->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
+	uber_graph_get_allocation(graph, &alloc);
 	uber_graph_get_pixmap_rect(graph, &rect);
 	cr = cairo_create(priv->fg_surface);
 	/*
@@ -990,11 +1681,7 @@ uber_graph_render_fg (UberGraph *graph) /* IN */
 			/*
 			 * Clear content area.
 			 */
-			cairo_save(cr);
-			cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-			gdk_cairo_rectangle(cr, &rect);
-			cairo_fill(cr);
-			cairo_restore(cr);
+			uber_graph_clear_fg(graph, cr, &rect);
 
 #if 0
 			/*
@@ -1031,11 +1718,7 @@ uber_graph_render_fg (UberGraph *graph) /* IN */
 			/*
 			 * Clear content area.
 			 */
-			cairo_save(cr);
-			cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
-			gdk_cairo_rectangle(cr, &rect);
-			cairo_fill(cr);
-			cairo_restore(cr);
+			uber_graph_clear_fg(graph, cr, &rect);
 			/*
 			 * Draw the entire foreground.
 			 */
@@ -1084,6 +1767,7 @@ uber_graph_redraw (UberGraph *graph) /* IN */
 	priv->fg_dirty = TRUE;
 	priv->bg_dirty = TRUE;
 	priv->full_draw = TRUE;
+	uber_graph_invalidate_inactive(graph);
 	gtk_widget_queue_draw(GTK_WIDGET(graph));
 }
 
@@ -1109,6 +1793,34 @@ uber_graph_get_yrange (UberGraph *graph, /* IN */
 	}
 }
 
+/**
+ * uber_graph_get_yscale:
+ * @graph: A #UberGraph.
+ * @scale: (out): A location for the #UberScale.
+ * @scale_data: (out): A location for the user data of @scale.
+ *
+ * Retrieves the scale used to place values vertically so that the Y axis
+ * can be drawn to match.  Graphs that do not say use a linear scale.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_graph_get_yscale (UberGraph *graph,      /* IN */
+                       UberScale *scale,      /* OUT */
+                       gpointer  *scale_data) /* OUT */
+{
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(scale != NULL);
+	g_return_if_fail(scale_data != NULL);
+
+	*scale = uber_scale_linear;
+	*scale_data = NULL;
+	if (UBER_GRAPH_GET_CLASS(graph)->get_yscale) {
+		UBER_GRAPH_GET_CLASS(graph)->get_yscale(graph, scale, scale_data);
+	}
+}
+
 /**
  * uber_graph_set_format:
  * @graph: A UberGraph.
@@ -1129,6 +1841,7 @@ uber_graph_set_format (UberGraph       *graph, /* IN */
 	priv = graph->priv;
 	priv->format = format;
 	priv->bg_dirty = TRUE;
+	priv->inactive.bg_dirty = TRUE;
 	gtk_widget_queue_draw(GTK_WIDGET(graph));
 }
 
@@ -1138,7 +1851,6 @@ uber_graph_render_x_axis (UberGraph *graph, /* IN */
 {
 	UberGraphPrivate *priv;
 	const gdouble dashes[] = { 1.0, 2.0 };
-	PangoFontDescription *fd;
 	PangoLayout *pl;
 	GtkStyleContext *style;
     GdkRGBA fg_color;
@@ -1164,11 +1876,6 @@ uber_graph_render_x_axis (UberGraph *graph, /* IN */
 	 * Draw ticks.
 	 */
 	cairo_save(cr);
-	pl = pango_cairo_create_layout(cr);
-	fd = pango_font_description_new();
-	pango_font_description_set_family_static(fd, "Monospace");
-	pango_font_description_set_size(fd, 6 * PANGO_SCALE);
-	pango_layout_set_font_description(pl, fd);
 	gdk_cairo_set_source_rgba(cr, &fg_color);
 	cairo_set_line_width(cr, 1.0);
 	cairo_set_dash(cr, dashes, G_N_ELEMENTS(dashes), 0);
@@ -1191,8 +1898,7 @@ uber_graph_render_x_axis (UberGraph *graph, /* IN */
 		 */
 		if (priv->show_xlabels) {
 			g_snprintf(text, sizeof(text), "%d", i * 10);
-			pango_layout_set_text(pl, text, -1);
-			pango_layout_get_pixel_size(pl, &wi, &hi);
+			pl = uber_layout_cache_lookup(LABEL_FONT, text, &wi, &hi);
 			if (i != 0 && i != count) {
 				cairo_move_to(cr, x - (wi / 2), y + h);
 			} else if (i == 0) {
@@ -1207,8 +1913,6 @@ uber_graph_render_x_axis (UberGraph *graph, /* IN */
 			pango_cairo_show_layout(cr, pl);
 		}
 	}
-	g_object_unref(pl);
-	pango_font_description_free(fd);
 	cairo_restore(cr);
 }
 
@@ -1223,7 +1927,6 @@ uber_graph_render_y_line (UberGraph   *graph,     /* IN */
 {
 	UberGraphPrivate *priv;
 	const gdouble dashes[] = { 1.0, 2.0 };
-	PangoFontDescription *fd;
 	PangoLayout *pl;
 	GtkStyleContext *style;
     GdkRGBA fg_color;
@@ -1241,10 +1944,14 @@ uber_graph_render_y_line (UberGraph   *graph,     /* IN */
 	style = gtk_widget_get_style_context(GTK_WIDGET(graph));
     gtk_style_context_get_color(style, GTK_STATE_FLAG_NORMAL, &fg_color);
 	/*
-	 * Draw grid line.
+	 * Draw grid line.  Flattened graphs repeat one column of the content
+	 * area under new content, so their lines must be solid to look the
+	 * same everywhere.
 	 */
 	cairo_save(cr);
-	cairo_set_dash(cr, dashes, G_N_ELEMENTS(dashes), 0);
+	if (!priv->flatten) {
+		cairo_set_dash(cr, dashes, G_N_ELEMENTS(dashes), 0);
+	}
 	cairo_set_line_width(cr, 1.0);
 	gdk_cairo_set_source_rgba(cr, &fg_color);
 	cairo_move_to(cr, priv->content_rect.x - priv->tick_len, real_y);
@@ -1270,13 +1977,7 @@ uber_graph_render_y_line (UberGraph   *graph,     /* IN */
 		/*
 		 * Render pango layout.
 		 */
-		pl = pango_cairo_create_layout(cr);
-		fd = pango_font_description_new();
-		pango_font_description_set_family_static(fd, "Monospace");
-		pango_font_description_set_size(fd, 6 * PANGO_SCALE);
-		pango_layout_set_font_description(pl, fd);
-		pango_layout_set_text(pl, text, -1);
-		pango_layout_get_pixel_size(pl, &width, &height);
+		pl = uber_layout_cache_lookup(LABEL_FONT, text, &width, &height);
 		cairo_move_to(cr, priv->content_rect.x - priv->tick_len - width - 3,
 		              real_y - height / 2);
 		pango_cairo_show_layout(cr, pl);
@@ -1284,8 +1985,6 @@ uber_graph_render_y_line (UberGraph   *graph,     /* IN */
 		 * Cleanup resources.
 		 */
 		g_free(text);
-		pango_font_description_free(fd);
-		g_object_unref(pl);
 		cairo_restore(cr);
 	}
 }
@@ -1299,6 +1998,8 @@ uber_graph_render_y_axis_percent (UberGraph *graph,       /* IN */
 {
 	static const gchar format[] = "%0.0f %%";
 	UberGraphPrivate *priv;
+	UberScale scale;
+	gpointer scale_data;
 	gdouble value;
 	gdouble y;
 	gint i;
@@ -1310,22 +2011,31 @@ uber_graph_render_y_axis_percent (UberGraph *graph,       /* IN */
 	g_return_if_fail(n_lines < 6);
 
 	priv = graph->priv;
+	uber_graph_get_yscale(graph, &scale, &scale_data);
 	/*
-	 * Render top and bottom lines.
+	 * Render top and bottom lines, labeled with the percentage the graph's
+	 * scale places there.
 	 */
+	value = uber_scale_invert(scale, range, pixel_range, pixel_range->range,
+	                          scale_data);
 	uber_graph_render_y_line(graph, cr,
 	                         priv->content_rect.y - 1,
-	                         TRUE, FALSE, format, 100.);
+	                         TRUE, FALSE, format, value);
+	value = uber_scale_invert(scale, range, pixel_range, 0., scale_data);
 	uber_graph_render_y_line(graph, cr,
 	                         RECT_BOTTOM(priv->content_rect),
-	                         TRUE, FALSE, format, 0.);
+	                         TRUE, FALSE, format, value);
 	/*
-	 * Render lines between the edges.
+	 * Render lines between the edges, spaced evenly on screen like those of
+	 * uber_graph_render_y_axis_direct().
 	 */
 	for (i = 1; i < n_lines; i++) {
-		value = (n_lines - i) / (gfloat)n_lines;
-		y = pixel_range->end - (pixel_range->range * value);
-		value *= 100.;
+		y = floor(pixel_range->range / (gfloat)(n_lines) * (gfloat)i);
+		if (y == 0 || y == pixel_range->begin || y == pixel_range->end) {
+			continue;
+		}
+		value = uber_scale_invert(scale, range, pixel_range, y, scale_data);
+		y = pixel_range->end - y;
 		uber_graph_render_y_line(graph, cr, y,
 		                         !priv->show_ylines, FALSE,
 		                         format, value);
@@ -1352,35 +2062,40 @@ uber_graph_render_y_axis_direct (UberGraph *graph,       /* IN */
 	static const gchar format[] = "%0.1f%s";
 	const gchar *modifier = "";
 	UberGraphPrivate *priv;
+	UberScale scale;
+	gpointer scale_data;
 	gdouble value;
 	gdouble y;
 	gint i;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
+/*
+ * Negative values are condensed by their magnitude and keep their sign.
+ */
 #define CONDENSE(v) \
 G_STMT_START { \
     if (kibi) { \
-        if ((v) >= 1073741824.) { \
+        if (fabs(v) >= 1073741824.) { \
             (v) /= 1073741824.; \
             modifier = " Gi"; \
-        } else if ((v) >= 1048576.) { \
+        } else if (fabs(v) >= 1048576.) { \
             (v) /= 1048576.; \
             modifier = " Mi"; \
-        } else if ((v) >= 1024.) { \
+        } else if (fabs(v) >= 1024.) { \
             (v) /= 1024.; \
             modifier = " Ki"; \
         } else { \
             modifier = ""; \
         } \
     } else {  \
-        if ((v) >= 1000000000.) { \
+        if (fabs(v) >= 1000000000.) { \
             (v) /= 1000000000.; \
             modifier = " G"; \
-        } else if ((v) >= 1000000.) { \
+        } else if (fabs(v) >= 1000000.) { \
             (v) /= 1000000.; \
             modifier = " M"; \
-        } else if ((v) >= 1000.) { \
+        } else if (fabs(v) >= 1000.) { \
             (v) /= 1000.; \
             modifier = " K"; \
         } else { \
@@ -1390,31 +2105,34 @@ G_STMT_START { \
 } G_STMT_END
 
 	priv = graph->priv;
+	uber_graph_get_yscale(graph, &scale, &scale_data);
 	/*
-	 * Render top and bottom lines.
+	 * Render top and bottom lines.  Like the lines between them, they are
+	 * labeled with the value the graph's scale places there, which need not
+	 * be the edge of @range; a log scale starts above zero.
 	 */
-	value = range->end;
+	value = uber_scale_invert(scale, range, pixel_range, pixel_range->range,
+	                          scale_data);
 	CONDENSE(value);
 	uber_graph_render_y_line(graph, cr,
 	                         priv->content_rect.y - 1,
 	                         TRUE, FALSE, format, value, modifier);
-	value = range->begin;
+	value = uber_scale_invert(scale, range, pixel_range, 0., scale_data);
 	CONDENSE(value);
 	uber_graph_render_y_line(graph, cr,
 	                         RECT_BOTTOM(priv->content_rect),
 	                         TRUE, FALSE, format, value, modifier);
 	/*
-	 * Render lines between the edges.
+	 * Render lines between the edges.  Lines are spaced evenly on screen
+	 * and labeled with the value the graph's scale places there, so
+	 * non-linear scales get correct labels too.
 	 */
 	for (i = 1; i < n_lines; i++) {
-		y = value = range->range / (gfloat)(n_lines) * (gfloat)i;
-		/*
-		 * TODO: Use proper scale.
-		 */
-		uber_scale_linear(range, pixel_range, &y, NULL);
+		y = floor(pixel_range->range / (gfloat)(n_lines) * (gfloat)i);
 		if (y == 0 || y == pixel_range->begin || y == pixel_range->end) {
 			continue;
 		}
+		value = uber_scale_invert(scale, range, pixel_range, y, scale_data);
 		y = pixel_range->end - y;
 		CONDENSE(value);
 		uber_graph_render_y_line(graph, cr, y,
@@ -1500,7 +2218,7 @@ uber_graph_render_bg (UberGraph *graph) /* IN */
 	 * Acquire resources.
 	 */
 	priv = graph->priv;
-	gtk_widget_get_allocation(GTK_WIDGET(graph), &alloc);
+	uber_graph_get_allocation(graph, &alloc);
 	style = gtk_widget_get_style_context(GTK_WIDGET(graph));
     gtk_style_context_get_color(style, GTK_STATE_FLAG_NORMAL, &fg_color);
     gtk_style_context_get_color(style, GTK_STATE_FLAG_SELECTED, &light_color);
@@ -1547,31 +2265,33 @@ uber_graph_render_bg (UberGraph *graph) /* IN */
 	 */
 	uber_graph_render_y_axis(graph, cr);
 	uber_graph_render_x_axis(graph, cr);
+	cairo_destroy(cr);
+	/*
+	 * When flattening, keep a copy of the leftmost column of the content
+	 * area.  It has the content background and the solid Y grid lines but
+	 * no X grid line, so it can be repeated under new foreground content.
+	 */
+	UNSET_SURFACE(priv->column_surface);
+	if (priv->flatten) {
+		priv->column_surface =
+			cairo_surface_create_similar(priv->bg_surface,
+			                             CAIRO_CONTENT_COLOR, 1, alloc.height);
+		cr = cairo_create(priv->column_surface);
+		cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		cairo_set_source_surface(cr, priv->bg_surface,
+		                         -priv->content_rect.x, 0);
+		cairo_paint(cr);
+		cairo_destroy(cr);
+		/*
+		 * The foreground must be repainted over the new column.
+		 */
+		priv->fg_dirty = TRUE;
+		priv->full_draw = TRUE;
+	}
 	/*
 	 * Background is no longer dirty.
 	 */
 	priv->bg_dirty = FALSE;
-	/*
-	 * Cleanup.
-	 */
-	cairo_destroy(cr);
-}
-
-static inline void
-g_time_val_subtract (GTimeVal *a, /* IN */
-                     GTimeVal *b, /* IN */
-                     GTimeVal *c) /* OUT */
-{
-	g_return_if_fail(a != NULL);
-	g_return_if_fail(b != NULL);
-	g_return_if_fail(c != NULL);
-
-	c->tv_sec = a->tv_sec - b->tv_sec;
-	c->tv_usec = a->tv_usec - b->tv_usec;
-	if (c->tv_usec < 0) {
-		c->tv_usec += G_USEC_PER_SEC;
-		c->tv_sec -= 1;
-	}
 }
 
 /**
@@ -1588,21 +2308,49 @@ static gfloat
 uber_graph_get_fps_offset (UberGraph *graph) /* IN */
 {
 	UberGraphPrivate *priv;
-	GTimeVal rel = { 0 };
-	GTimeVal tv;
+	gint64 rel;
 	gfloat f;
 
 	g_return_val_if_fail(UBER_IS_GRAPH(graph), 0.);
 
 	priv = graph->priv;
-	g_get_current_time(&tv);
-	g_time_val_subtract(&tv, &priv->dps_tv, &rel);
-	f = ((rel.tv_sec * 1000) + (rel.tv_usec / 1000))
-	  / (1000. / priv->dps) /* MSec Per Data Point */
-	  * priv->dps_each;     /* Pixels Per Data Point */
+	/*
+	 * The frame clock time is on the same monotonic clock, and is when the
+	 * frame being drawn will be shown.
+	 */
+	rel = (priv->tick_handler && priv->frame_time) ? priv->frame_time
+	                                               : g_get_monotonic_time();
+	rel -= priv->dps_time;
+	f = rel
+	  / (G_USEC_PER_SEC / priv->dps) /* USec Per Data Point */
+	  * priv->dps_each;              /* Pixels Per Data Point */
 	return MIN(f, (priv->dps_each - priv->fps_each));
 }
 
+/**
+ * uber_graph_get_ring_x:
+ * @graph: A #UberGraph.
+ *
+ * Calculates where the oldest part of the foreground ring buffer is placed
+ * in the current frame.  The newest part always follows it at a fixed
+ * distance, so this identifies the frame.  The position is snapped to a
+ * whole pixel unless scrolling smoothly.
+ *
+ * Returns: The x offset of the first foreground ring segment.
+ * Side effects: None.
+ */
+static gdouble
+uber_graph_get_ring_x (UberGraph *graph) /* IN */
+{
+	UberGraphPrivate *priv;
+	gdouble x;
+
+	priv = graph->priv;
+	x = ((priv->x_slots - priv->dps_slot) * priv->dps_each)
+	  - uber_graph_get_fps_offset(graph);
+	return priv->smooth_scroll ? x : floor(x);
+}
+
 /**
  * uber_graph_draw:
  * @widget: A #GtkWidget.
@@ -1618,14 +2366,21 @@ uber_graph_draw 	(GtkWidget      *widget, /* IN */
 {
 	UberGraphPrivate *priv;
 	GtkAllocation alloc;
+	cairo_region_t *region;
+	GdkRectangle clip;
+	GdkRectangle area;
+	GdkRectangle part;
 //	cairo_t *cr;
-	gfloat offset;
-	gint x;
+	cairo_surface_t *ring;
+	cairo_pattern_t *pattern;
+	gdouble x;
+	gint split;
+	gint i;
 
 	g_return_val_if_fail(UBER_IS_GRAPH(widget), FALSE);
 
 	priv = UBER_GRAPH(widget)->priv;
-	gtk_widget_get_allocation(widget, &alloc);
+	uber_graph_get_allocation(UBER_GRAPH(widget), &alloc);
 	priv->fps_count++;
 	/*
 	 * Ensure that the texture is initialized.
@@ -1661,40 +2416,88 @@ uber_graph_draw 	(GtkWidget      *widget, /* IN */
 		uber_graph_render_fg(UBER_GRAPH(widget));
 	}
 	/*
-	 * Paint the background to the exposure area.
+	 * Only the damaged area needs painting.  Everything outside of it is
+	 * already on screen.
+	 */
+	if (!gdk_cairo_get_clip_rectangle(cr, &clip)) {
+		return FALSE;
+	}
+	/*
+	 * Paint the background to the exposure area.  A flattened foreground
+	 * covers the content area completely, so skip the background there.
 	 */
 	cairo_save(cr);
 	cairo_set_source_surface(cr, priv->bg_surface, 0, 0);
-	cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
+	if (priv->flatten) {
+		region = cairo_region_create_rectangle(&clip);
+		cairo_region_subtract_rectangle(region, &priv->content_rect);
+		for (i = 0; i < cairo_region_num_rectangles(region); i++) {
+			cairo_region_get_rectangle(region, i, &part);
+			gdk_cairo_rectangle(cr, &part);
+		}
+		cairo_region_destroy(region);
+	} else {
+		gdk_cairo_rectangle(cr, &clip);
+	}
 	cairo_fill(cr);
 	cairo_restore(cr);
 	/*
-	 * Draw the foreground.
+	 * Draw the foreground if the damage reaches the content area.
 	 */
-	offset = uber_graph_get_fps_offset(UBER_GRAPH(widget));
-	if (priv->have_rgba) {
+	x = uber_graph_get_ring_x(UBER_GRAPH(widget));
+	priv->fps_last_x = x;
+	if (!gdk_rectangle_intersect(&clip, &priv->content_rect, &area)) {
+		return FALSE;
+	}
+	if (priv->have_rgba || priv->flatten || priv->offscreen) {
 		cairo_save(cr);
 		/*
-		 * Clip exposure to the content area.
+		 * A flattened foreground is opaque and is copied as is.
 		 */
-		cairo_reset_clip(cr);
-		gdk_cairo_rectangle(cr, &priv->content_rect);
-		cairo_clip(cr);
+		if (priv->flatten) {
+			cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+		}
 		/*
-		 * Data in the fg surface is a ring bufer. Render the first portion
-		 * at its given offset.
+		 * When scrolling smoothly the ring is tiled as one repeating pattern
+		 * so that filtering blends across the seam between its two ends.
+		 * The ring is never moved vertically, so rows stay sharp.
 		 */
-		x = ((priv->x_slots - priv->dps_slot) * priv->dps_each) - offset;
-		cairo_set_source_surface(cr, priv->fg_surface, (gint)x, 0);
-		gdk_cairo_rectangle(cr, &priv->content_rect);
-		cairo_fill(cr);
+		if (priv->smooth_scroll) {
+			ring = cairo_surface_create_for_rectangle(priv->fg_surface,
+			                                          priv->nonvis_rect.x, 0,
+			                                          priv->nonvis_rect.width,
+			                                          alloc.height);
+			cairo_set_source_surface(cr, ring, priv->nonvis_rect.x + x, 0);
+			pattern = cairo_get_source(cr);
+			cairo_pattern_set_extend(pattern, CAIRO_EXTEND_REPEAT);
+			cairo_pattern_set_filter(pattern, CAIRO_FILTER_BILINEAR);
+			gdk_cairo_rectangle(cr, &area);
+			cairo_fill(cr);
+			cairo_restore(cr);
+			cairo_surface_destroy(ring);
+			return FALSE;
+		}
 		/*
-		 * Render the second part of the ring surface buffer.
+		 * Data in the fg surface is a ring buffer.  The older part is drawn
+		 * left of the split and the newer part right of it, so each pixel
+		 * is composited once.
 		 */
-		x = (priv->dps_each * -priv->dps_slot) - offset;
-		cairo_set_source_surface(cr, priv->fg_surface, (gint)x, 0);
-		gdk_cairo_rectangle(cr, &priv->content_rect);
-		cairo_fill(cr);
+		split = priv->content_rect.x + x;
+		part = area;
+		part.width = CLAMP(split - area.x, 0, area.width);
+		if (part.width) {
+			cairo_set_source_surface(cr, priv->fg_surface,
+			                         x - (priv->x_slots * priv->dps_each), 0);
+			gdk_cairo_rectangle(cr, &part);
+			cairo_fill(cr);
+		}
+		part.x = area.x + part.width;
+		part.width = area.width - part.width;
+		if (part.width) {
+			cairo_set_source_surface(cr, priv->fg_surface, x, 0);
+			gdk_cairo_rectangle(cr, &part);
+			cairo_fill(cr);
+		}
 		/*
 		 * Cleanup.
 		 */
@@ -1733,6 +2536,7 @@ uber_graph_style_set (GtkWidget *widget,    /* IN */
 	WIDGET_CLASS->style_set(widget, old_style);
 	priv->fg_dirty = TRUE;
 	priv->bg_dirty = TRUE;
+	priv->layout_serial++;
 	gtk_widget_queue_draw(widget);
 }
 
@@ -1764,22 +2568,9 @@ uber_graph_size_allocate (GtkWidget     *widget, /* IN */
 		return;
 	}
 	/*
-	 * Recalculate rectangles.
-	 */
-	uber_graph_calculate_rects(graph);
-	/*
-	 * Recreate server side surface.
-	 */
-	UNSET_SURFACE(priv->bg_surface);
-	UNSET_SURFACE(priv->fg_surface);
-	uber_graph_init_bg(graph);
-	uber_graph_init_texture(graph);
-	/*
-	 * Mark foreground and background as dirty.
+	 * Recalculate rectangles and recreate server side surfaces.
 	 */
-	priv->fg_dirty = TRUE;
-	priv->bg_dirty = TRUE;
-	priv->full_draw = TRUE;
+	uber_graph_reset_surfaces(graph);
 	gtk_widget_queue_draw(widget);
 }
 
@@ -1837,6 +2628,119 @@ uber_graph_add_label (UberGraph *graph, /* IN */
 	gtk_widget_show(GTK_WIDGET(label));
 }
 
+/**
+ * uber_graph_render_to_surface:
+ * @graph: A #UberGraph.
+ * @surface: A cairo image surface.
+ *
+ * Renders @graph into @surface, laid out for the size of @surface.  The
+ * widget does not need to be realized or placed in a window, though GTK
+ * must still be initialized with a display, as styling is read from the
+ * widget.  A graph that is never shown starts collecting data on its
+ * first render.
+ *
+ * The offscreen layout and surfaces are kept apart from those used for
+ * the window, so rendering repeatedly at one size only redraws what the
+ * new data ticks changed, and the window's layout is left untouched.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_graph_render_to_surface (UberGraph       *graph,   /* IN */
+                              cairo_surface_t *surface) /* IN */
+{
+	UberGraphPrivate *priv;
+	gboolean realized;
+	gboolean stale;
+	cairo_t *cr;
+	gint width;
+	gint height;
+
+	g_return_if_fail(UBER_IS_GRAPH(graph));
+	g_return_if_fail(surface != NULL);
+	g_return_if_fail(cairo_surface_get_type(surface) ==
+	                 CAIRO_SURFACE_TYPE_IMAGE);
+
+	priv = graph->priv;
+	width = cairo_image_surface_get_width(surface);
+	height = cairo_image_surface_get_height(surface);
+	realized = gtk_widget_get_realized(GTK_WIDGET(graph));
+	/*
+	 * Switch to the offscreen layout, laying it out for the target unless
+	 * the last offscreen render was already at this size.
+	 */
+	stale = FALSE;
+	if (!priv->offscreen) {
+		stale = uber_graph_swap_layout(graph);
+	}
+	if (stale || !priv->offscreen ||
+	    priv->offscreen_alloc.width != width ||
+	    priv->offscreen_alloc.height != height) {
+		priv->offscreen = TRUE;
+		priv->offscreen_alloc.x = 0;
+		priv->offscreen_alloc.y = 0;
+		priv->offscreen_alloc.width = width;
+		priv->offscreen_alloc.height = height;
+		uber_graph_reset_surfaces(graph);
+	}
+	/*
+	 * Data is otherwise only collected once the widget is realized.
+	 */
+	if (!realized && !priv->dps_handler) {
+		if (UBER_GRAPH_GET_CLASS(graph)->set_stride) {
+			UBER_GRAPH_GET_CLASS(graph)->set_stride(graph, priv->x_slots);
+		}
+		uber_graph_register_dps_handler(graph);
+	}
+	cr = cairo_create(surface);
+	uber_graph_draw(GTK_WIDGET(graph), cr);
+	cairo_destroy(cr);
+	cairo_surface_flush(surface);
+	/*
+	 * Switch a realized graph back to the layout it is shown with.
+	 */
+	if (realized) {
+		if (uber_graph_swap_layout(graph)) {
+			uber_graph_reset_surfaces(graph);
+			gtk_widget_queue_draw(GTK_WIDGET(graph));
+		}
+	}
+}
+
+/**
+ * uber_graph_render_to_png:
+ * @graph: A #UberGraph.
+ * @filename: The file to write.
+ * @width: The width of the image.
+ * @height: The height of the image.
+ *
+ * Renders @graph into a new image of @width by @height pixels using
+ * uber_graph_render_to_surface() and saves it to @filename as a PNG.
+ *
+ * Returns: %CAIRO_STATUS_SUCCESS if the image was written.
+ * Side effects: None.
+ */
+cairo_status_t
+uber_graph_render_to_png (UberGraph   *graph,    /* IN */
+                          const gchar *filename, /* IN */
+                          gint         width,    /* IN */
+                          gint         height)   /* IN */
+{
+	cairo_surface_t *surface;
+	cairo_status_t status;
+
+	g_return_val_if_fail(UBER_IS_GRAPH(graph), CAIRO_STATUS_NULL_POINTER);
+	g_return_val_if_fail(filename != NULL, CAIRO_STATUS_NULL_POINTER);
+	g_return_val_if_fail(width > 0 && height > 0, CAIRO_STATUS_INVALID_SIZE);
+
+	surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+	uber_graph_render_to_surface(graph, surface);
+	status = cairo_surface_write_to_png(surface, filename);
+	cairo_surface_destroy(surface);
+	return status;
+}
+
 /**
  * uber_graph_take_screenshot:
  * @graph: A #UberGraph.
@@ -1852,10 +2756,8 @@ uber_graph_take_screenshot (UberGraph *graph) /* IN */
 	GtkWidget *widget;
 	GtkWidget *dialog;
 	GtkAllocation alloc;
-	const gchar *filename;
+	gchar *filename;
 	cairo_status_t status;
-	cairo_surface_t *surface;
-	cairo_t *cr;
 
 	g_return_if_fail(UBER_IS_GRAPH(graph));
 
@@ -1873,32 +2775,15 @@ uber_graph_take_screenshot (UberGraph *graph) /* IN */
 	                                     NULL);
 	if (GTK_RESPONSE_ACCEPT == gtk_dialog_run(GTK_DIALOG(dialog))) {
 		/*
-		 * Create surface and cairo context.
-		 */
-		surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-		                                     alloc.width, alloc.height);
-		cr = cairo_create(surface);
-		cairo_rectangle(cr, 0, 0, alloc.width, alloc.height);
-		cairo_clip(cr);
-
-		/* Paint to the image surface instead of the screen */
-		uber_graph_draw(widget, cr);
-
-		/*
-		 * Save surface to png.
+		 * Render at the size of the widget and save to png.
 		 */
 		filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
-		status = cairo_surface_write_to_png(surface, filename);
+		status = uber_graph_render_to_png(graph, filename,
+		                                  alloc.width, alloc.height);
 		if (status != CAIRO_STATUS_SUCCESS) {
 			g_critical("Failed to save pixmap to file.");
-			goto cleanup;
 		}
-		/*
-		 * Cleanup resources.
-		 */
-	  cleanup:
-		cairo_destroy(cr);
-		cairo_surface_destroy(surface);
+		g_free(filename);
 	}
 	gtk_widget_destroy(dialog);
 }
@@ -1921,15 +2806,10 @@ uber_graph_toggle_paused (UberGraph *graph) /* IN */
 
 	priv = graph->priv;
 	priv->paused = !priv->paused;
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-		priv->fps_handler = 0;
-	} else {
-		if (!priv->paused) {
-			uber_graph_redraw(graph);
-		}
-		uber_graph_register_fps_handler(graph);
+	if (!priv->paused) {
+		uber_graph_redraw(graph);
 	}
+	uber_graph_register_fps_handler(graph);
 }
 
 /**
@@ -1998,17 +2878,26 @@ uber_graph_dispose (GObject *object) /* IN */
 	/*
 	 * Stop any timeout handlers.
 	 */
-	if (priv->fps_handler) {
-		g_source_remove(priv->fps_handler);
-	}
+	uber_graph_unregister_fps_handler(graph);
 	if (priv->dps_handler) {
-		g_source_remove(priv->dps_handler);
+		uber_scheduler_remove(priv->dps_handler);
+		priv->dps_handler = 0;
+	}
+	if (priv->toplevel) {
+		g_signal_handlers_disconnect_by_data(priv->toplevel, graph);
+		g_object_remove_weak_pointer(G_OBJECT(priv->toplevel),
+		                             (gpointer *)&priv->toplevel);
+		priv->toplevel = NULL;
 	}
 	/*
 	 * Destroy textures.
 	 */
 	UNSET_SURFACE(priv->bg_surface);
 	UNSET_SURFACE(priv->fg_surface);
+	UNSET_SURFACE(priv->column_surface);
+	UNSET_SURFACE(priv->inactive.bg_surface);
+	UNSET_SURFACE(priv->inactive.fg_surface);
+	UNSET_SURFACE(priv->inactive.column_surface);
 	/*
 	 * Call base class.
 	 */
@@ -2148,9 +3037,9 @@ uber_graph_init (UberGraph *graph) /* IN */
 	 */
 	priv->tick_len = 10;
 	priv->fps = 20;
-	priv->fps_real = 1000. / priv->fps;
 	priv->dps = 1.;
 	priv->x_slots = 60;
+	priv->fps_last_x = -G_MAXDOUBLE;
 	priv->fg_dirty = TRUE;
 	priv->bg_dirty = TRUE;
 	priv->full_draw = TRUE;
@@ -23,6 +23,7 @@
 
 #include "uber-range.h"
 #include "uber-label.h"
+#include "uber-scale.h"
 
 G_BEGIN_DECLS
 
@@ -61,6 +62,9 @@ struct _UberGraphClass
 	gboolean   (*get_next_data) (UberGraph    *graph);
 	void       (*get_yrange)    (UberGraph    *graph,
 	                             UberRange    *range);
+	void       (*get_yscale)    (UberGraph    *graph,
+	                             UberScale    *scale,
+	                             gpointer     *scale_data);
 	void       (*render)        (UberGraph    *graph,
 	                             cairo_t      *cairo,
 	                             GdkRectangle *content_area,
@@ -80,6 +84,11 @@ void       uber_graph_set_dps          (UberGraph       *graph,
                                         gfloat           dps);
 void       uber_graph_set_fps          (UberGraph       *graph,
                                         guint            fps);
+gboolean   uber_graph_get_sync_to_frame_clock (UberGraph *graph);
+void       uber_graph_set_sync_to_frame_clock (UberGraph *graph,
+                                               gboolean   sync_to_frame_clock);
+gfloat     uber_graph_get_dps          (UberGraph       *graph);
+gint64     uber_graph_get_data_time    (UberGraph       *graph);
 void       uber_graph_redraw           (UberGraph       *graph);
 void       uber_graph_set_format       (UberGraph       *graph,
                                         UberGraphFormat  format);
@@ -97,7 +106,19 @@ void       uber_graph_set_show_xlabels (UberGraph       *graph,
 gboolean   uber_graph_get_show_ylines  (UberGraph       *graph);
 void       uber_graph_set_show_ylines  (UberGraph       *graph,
                                         gboolean         show_ylines);
+gboolean   uber_graph_get_flatten      (UberGraph       *graph);
+void       uber_graph_set_flatten      (UberGraph       *graph,
+                                        gboolean         flatten);
+gboolean   uber_graph_get_smooth_scroll (UberGraph      *graph);
+void       uber_graph_set_smooth_scroll (UberGraph      *graph,
+                                         gboolean        smooth_scroll);
 void       uber_graph_scale_changed    (UberGraph       *graph);
+void       uber_graph_render_to_surface (UberGraph      *graph,
+                                         cairo_surface_t *surface);
+cairo_status_t uber_graph_render_to_png (UberGraph      *graph,
+                                         const gchar    *filename,
+                                         gint            width,
+                                         gint            height);
 
 G_END_DECLS
 
@@ -20,29 +20,97 @@
 #include "config.h"
 #endif
 
+#include <math.h>
 #include <string.h>
 
 #include "uber-heat-map.h"
+#include "uber-extrema.h"
 #include "g-ring.h"
 
 /**
  * SECTION:uber-heat-map.h
  * @title: UberHeatMap
- * @short_description:
+ * @short_description: A graph of how values are distributed over time.
  *
- * Section overview.
+ * Each data tick, the values for the tick are gathered into an
+ * #UberHistogram, either filled in place by a histogram func or recorded
+ * from the values of a data func.  The histogram of every tick is kept,
+ * along with a column of counts for a fixed number of buckets spread across
+ * the range of the graph.  The size of a column does not depend on how many
+ * values it received.  Columns are drawn with the foreground color, more
+ * opaque where a bucket holds more values.
+ *
+ * The count of each histogram bucket is shared among the column buckets
+ * its values span, in proportion to the overlap, so no column bucket is
+ * left empty because it falls between histogram buckets.  Values are
+ * expected to be non-negative; negative values are counted with the
+ * smallest values, in the first bucket.
+ *
+ * Columns are written as pixels, one per bucket, into an image surface
+ * through a table of precomputed colors.  The image is then stretched over
+ * the content area in a single paint.
+ *
+ * The table is either the foreground color at increasing opacity or one of
+ * the perceptual color maps from #UberHeatMapColorMap.  How a count picks
+ * its color is set with uber_heat_map_set_normalize(): against the largest
+ * count of its own column, against the largest count of any column shown,
+ * or the same on a logarithmic scale.  The largest count shown is kept up
+ * to date as columns are added and scroll out, rather than searched for on
+ * each draw.
  */
 
 G_DEFINE_TYPE(UberHeatMap, uber_heat_map, UBER_TYPE_GRAPH)
 
+#define DEFAULT_BUCKETS (32)
+#define LUT_SIZE        (256)
+
+/*
+ * Evenly spaced stops of the color maps, as RGB.
+ */
+static const guint32 viridis_stops[] = {
+	0x440154, 0x46327e, 0x365c8d, 0x277f8e,
+	0x1fa187, 0x4ac16d, 0xa0da39, 0xfde725,
+};
+
+static const guint32 magma_stops[] = {
+	0x000004, 0x1c1044, 0x4f127b, 0x812581, 0xb5367a,
+	0xe55064, 0xfb8761, 0xfec287, 0xfcfdbf,
+};
+
+static const guint32 greys_stops[] = {
+	0xf0f0f0, 0x000000,
+};
+
 struct _UberHeatMapPrivate
 {
-	GRing           *raw_data;
+	GRing           *columns;       /* Bucket counts per tick. */
+	GRing           *sketches;      /* UberHistogram per tick. */
+	UberHistogram   *sketch;        /* Values of the current tick. */
+	UberHistogram   *merged;        /* Scratch for quantile queries. */
+	gdouble         *bucket_edges;  /* Sketch bucket edges, in column buckets. */
+	guint            n_buckets;     /* Buckets in each column. */
+	guint            stride;        /* Number of columns. */
+	gint64           n_ticks;       /* Columns appended so far. */
+	UberExtrema      extrema;       /* Largest count of each column shown. */
+	UberHeatMapNormalize normalize;
+	UberRange        range;         /* Range covered by the buckets. */
+	UberScale        scale;         /* Spacing of the buckets. */
+	UberScaleBatch   scale_batch;
+	gpointer         scale_data;
+	GDestroyNotify   scale_notify;
 	gboolean         fg_color_set;
-	GdkRGBA         fg_color;
+	GdkRGBA          fg_color;
+	UberHeatMapColorMap color_map;
+	gboolean         lut_valid;     /* If lut has been built. */
+	GdkRGBA          lut_color;     /* Color the lut was built for. */
+	guint32          lut[LUT_SIZE]; /* Premultiplied ARGB32 by intensity. */
+	cairo_surface_t *image;         /* Pixels for the columns being drawn. */
 	UberHeatMapFunc  func;
 	GDestroyNotify   func_destroy;
 	gpointer         func_user_data;
+	UberHeatMapHistogramFunc histogram_func;
+	GDestroyNotify   histogram_func_destroy;
+	gpointer         histogram_func_user_data;
 };
 
 /**
@@ -63,22 +131,242 @@ uber_heat_map_new (void)
 }
 
 /**
- * uber_heat_map_destroy_array:
- * @array: A #GArray.
+ * uber_heat_map_get_column:
+ * @map: A #UberHeatMap.
+ * @i: The index of the column, 0 being the newest.
  *
- * XXX
+ * Retrieves the bucket counts of a column.
+ *
+ * Returns: An array of n_buckets counts.
+ * Side effects: None.
+ */
+static inline guint32*
+uber_heat_map_get_column (UberHeatMap *map, /* IN */
+                          guint        i)   /* IN */
+{
+	GRing *ring = map->priv->columns;
+	guint slot;
+
+	slot = (ring->pos + ring->len - 1 - (i % ring->len)) % ring->len;
+	return (guint32 *)ring->data + ((gsize)slot * map->priv->n_buckets);
+}
+
+/**
+ * uber_heat_map_get_sketch:
+ * @map: A #UberHeatMap.
+ * @i: The index of the tick, 0 being the newest.
+ *
+ * Retrieves the histogram of a tick.  Ticks that never received data have
+ * an empty histogram.
+ *
+ * Returns: An #UberHistogram owned by @map.
+ * Side effects: None.
+ */
+static inline UberHistogram*
+uber_heat_map_get_sketch (UberHeatMap *map, /* IN */
+                          guint        i)   /* IN */
+{
+	GRing *ring = map->priv->sketches;
+	guint slot;
+
+	slot = (ring->pos + ring->len - 1 - (i % ring->len)) % ring->len;
+	return (UberHistogram *)(ring->data +
+	                         ((gsize)slot *
+	                          uber_histogram_get_size(map->priv->sketch)));
+}
+
+/**
+ * uber_heat_map_update_bucket_edges:
+ * @map: A #UberHeatMap.
+ *
+ * Works out where the edges of each histogram bucket fall among the
+ * column buckets, for the current range, scale and number of buckets.
+ * Edges outside of the range are moved to its ends.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_bucket_edges (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	UberRange bucket_range;
+	gdouble *values;
+	gdouble high;
+	guint n_values;
+	guint i;
+
+	priv = map->priv;
+	/*
+	 * Histogram buckets are contiguous, so bucket i spans edges i and
+	 * i + 1.
+	 */
+	n_values = uber_histogram_get_n_buckets(priv->sketch);
+	values = g_new(gdouble, n_values + 1);
+	for (i = 0; i < n_values; i++) {
+		uber_histogram_get_bucket(priv->sketch, i, &values[i], &high);
+	}
+	values[n_values] = high;
+	/*
+	 * Scaling to the bucket count, rather than to pixels, gives the
+	 * position of each edge in buckets.
+	 */
+	bucket_range.begin = 0.;
+	bucket_range.end = priv->n_buckets;
+	bucket_range.range = priv->n_buckets;
+	priv->bucket_edges = g_renew(gdouble, priv->bucket_edges, n_values + 1);
+	if (priv->scale_batch) {
+		priv->scale_batch(&priv->range, &bucket_range, values,
+		                  priv->bucket_edges, n_values + 1,
+		                  priv->scale_data);
+	} else {
+		uber_scale_apply(priv->scale, &priv->range, &bucket_range, values,
+		                 priv->bucket_edges, n_values + 1, priv->scale_data);
+	}
+	for (i = 0; i <= n_values; i++) {
+		if (!isnan(priv->bucket_edges[i])) {
+			priv->bucket_edges[i] = CLAMP(priv->bucket_edges[i], 0.,
+			                              priv->n_buckets);
+		}
+	}
+	g_free(values);
+}
+
+/**
+ * uber_heat_map_count:
+ * @map: A #UberHeatMap.
+ * @sketch: The histogram of a tick.
+ * @counts: (out): The column to count into, cleared first.
+ *
+ * Fills a column from the histogram of a tick.  The count of a histogram
+ * bucket is shared between the column buckets it overlaps, in proportion
+ * to the overlap, so column buckets narrower than histogram buckets are
+ * not left empty.  The cost depends only on the size of the histogram,
+ * not on the number of values it holds.
+ *
+ * Returns: The number of values counted.
+ * Side effects: None.
+ */
+static guint64
+uber_heat_map_count (UberHeatMap         *map,    /* IN */
+                     const UberHistogram *sketch, /* IN */
+                     guint32             *counts) /* OUT */
+{
+	UberHeatMapPrivate *priv;
+	guint64 n_counted = 0;
+	guint64 shared;
+	guint64 share;
+	guint32 count;
+	gdouble low;
+	gdouble high;
+	guint n_values;
+	guint first;
+	guint last;
+	guint i;
+	guint j;
+
+	priv = map->priv;
+	memset(counts, 0, sizeof(guint32) * priv->n_buckets);
+	if (!uber_histogram_get_count(sketch)) {
+		return 0;
+	}
+	n_values = uber_histogram_get_n_buckets(priv->sketch);
+	for (i = 0; i < n_values; i++) {
+		count = uber_histogram_get_bucket(sketch, i, NULL, NULL);
+		low = priv->bucket_edges[i];
+		high = priv->bucket_edges[i + 1];
+		if (!count || isnan(low) || isnan(high)) {
+			continue;
+		}
+		n_counted += count;
+		first = MIN((guint)low, priv->n_buckets - 1);
+		if (!(high > low)) {
+			counts[first] += count;
+			continue;
+		}
+		last = MIN((guint)ceil(high), priv->n_buckets) - 1;
+		/*
+		 * Round the running total rather than each share, so the shares
+		 * always add up to the count.
+		 */
+		shared = 0;
+		for (j = first; j <= last; j++) {
+			share = (guint64)(count * ((MIN(j + 1., high) - low) /
+			                           (high - low)) + .5) - shared;
+			counts[j] += share;
+			shared += share;
+		}
+	}
+	return n_counted;
+}
+
+/**
+ * uber_heat_map_push_column:
+ * @map: A #UberHeatMap.
+ * @counts: The bucket counts of the new column.
+ *
+ * Appends a column and slides the window of column maxima along with it,
+ * dropping the column that scrolled out.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_heat_map_destroy_array (gpointer data) /* IN */
+uber_heat_map_push_column (UberHeatMap   *map,    /* IN */
+                           const guint32 *counts) /* IN */
 {
-	GArray **ar = data;
+	UberHeatMapPrivate *priv;
+	guint32 max = 0;
+	guint i;
 
-	if (ar) {
-		g_array_unref(*ar);
+	priv = map->priv;
+	for (i = 0; i < priv->n_buckets; i++) {
+		max = MAX(max, counts[i]);
 	}
+	g_ring_append_vals(priv->columns, counts, 1);
+	uber_extrema_push(&priv->extrema, priv->n_ticks, max);
+	priv->n_ticks++;
+	uber_extrema_expire(&priv->extrema, priv->n_ticks - priv->columns->len);
+}
+
+/**
+ * uber_heat_map_reset_columns:
+ * @map: A #UberHeatMap.
+ *
+ * Rebuilds every column from the histograms of the ticks, for the current
+ * range, scale and number of buckets.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_reset_columns (UberHeatMap *map) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	guint32 *counts;
+	guint i;
+
+	priv = map->priv;
+	uber_heat_map_update_bucket_edges(map);
+	if (priv->columns) {
+		g_ring_unref(priv->columns);
+		priv->columns = NULL;
+	}
+	if (!priv->sketches) {
+		return;
+	}
+	/*
+	 * Append oldest to newest so that the columns line up with the ticks.
+	 */
+	priv->columns = g_ring_sized_new(sizeof(guint32) * priv->n_buckets,
+	                                 priv->sketches->len, NULL);
+	uber_extrema_clear(&priv->extrema);
+	counts = g_new(guint32, priv->n_buckets);
+	for (i = priv->sketches->len; i > 0; i--) {
+		uber_heat_map_count(map, uber_heat_map_get_sketch(map, i - 1), counts);
+		uber_heat_map_push_column(map, counts);
+	}
+	g_free(counts);
 }
 
 /**
@@ -99,11 +387,22 @@ uber_heat_map_set_stride (UberGraph *graph,  /* IN */
 	g_return_if_fail(UBER_IS_HEAT_MAP(graph));
 
 	priv = UBER_HEAT_MAP(graph)->priv;
-	if (priv->raw_data) {
-		g_ring_unref(priv->raw_data);
+	priv->stride = stride;
+	/*
+	 * Keep the most recent ticks if we already have a buffer.  Columns and
+	 * histograms are resized together, so they stay in step.  Maxima of the
+	 * columns dropped by shrinking leave the window with them.
+	 */
+	if (priv->sketches) {
+		g_ring_resize(priv->sketches, stride);
+		g_ring_resize(priv->columns, stride);
+		uber_extrema_expire(&priv->extrema,
+		                    priv->n_ticks - priv->columns->len);
+		return;
 	}
-	priv->raw_data = g_ring_sized_new(sizeof(GArray*), stride,
-	                                  uber_heat_map_destroy_array);
+	priv->sketches = g_ring_sized_new(uber_histogram_get_size(priv->sketch),
+	                                  stride, NULL);
+	uber_heat_map_reset_columns(UBER_HEAT_MAP(graph));
 }
 
 /**
@@ -134,11 +433,338 @@ uber_heat_map_set_data_func (UberHeatMap     *map,       /* IN */
 	priv->func_user_data = user_data;
 }
 
+/**
+ * uber_heat_map_set_histogram_func:
+ * @map: A #UberHeatMap.
+ * @func: An #UberHeatMapHistogramFunc.
+ * @user_data: user data for @func.
+ * @destroy: A #GDestroyNotify for @user_data, or %NULL.
+ *
+ * Sets the callback that records the values of each tick into a histogram
+ * provided by @map.  This is used in place of the data func.  The memory
+ * used per tick is constant however many values are recorded.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_histogram_func (UberHeatMap              *map,       /* IN */
+                                  UberHeatMapHistogramFunc  func,      /* IN */
+                                  gpointer                  user_data, /* IN */
+                                  GDestroyNotify            destroy)   /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (priv->histogram_func_destroy) {
+		priv->histogram_func_destroy(priv->histogram_func_user_data);
+	}
+	priv->histogram_func = func;
+	priv->histogram_func_destroy = destroy;
+	priv->histogram_func_user_data = user_data;
+}
+
+/**
+ * uber_heat_map_get_quantile:
+ * @map: A #UberHeatMap.
+ * @first: The first tick, 0 being the newest.
+ * @n_ticks: The number of ticks.
+ * @quantile: The quantile, between 0 and 1.
+ *
+ * Estimates the value below which @quantile of the values fall, over the
+ * @n_ticks ticks starting at @first.  The histograms of the ticks are
+ * merged, so this is cheap for any number of values.
+ *
+ * Returns: The value at @quantile, or %NAN if there were no values.
+ * Side effects: None.
+ */
+gdouble
+uber_heat_map_get_quantile (UberHeatMap *map,      /* IN */
+                            guint        first,    /* IN */
+                            guint        n_ticks,  /* IN */
+                            gdouble      quantile) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	UberHistogram *sketch;
+	guint i;
+
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map), NAN);
+
+	priv = map->priv;
+	if (!priv->sketches) {
+		return NAN;
+	}
+	uber_histogram_clear(priv->merged);
+	for (i = first; i < MIN(first + n_ticks, priv->sketches->len); i++) {
+		sketch = uber_heat_map_get_sketch(map, i);
+		if (uber_histogram_get_count(sketch)) {
+			uber_histogram_merge(priv->merged, sketch);
+		}
+	}
+	return uber_histogram_get_quantile(priv->merged, quantile);
+}
+
+/**
+ * uber_heat_map_get_color:
+ * @map: A #UberHeatMap.
+ * @color: (out): A location for the color.
+ *
+ * Retrieves the color that buckets are drawn with.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_color (UberHeatMap *map,   /* IN */
+                         GdkRGBA     *color) /* OUT */
+{
+	GtkStyleContext *style;
+
+	*color = map->priv->fg_color;
+	if (!map->priv->fg_color_set) {
+		style = gtk_widget_get_style_context(GTK_WIDGET(map));
+		gtk_style_context_get_color(style, GTK_STATE_FLAG_SELECTED, color);
+	}
+}
+
+/**
+ * uber_heat_map_fill_lut:
+ * @map: A #UberHeatMap.
+ * @stops: Evenly spaced RGB colors.
+ * @n_stops: The number of colors in @stops.
+ *
+ * Fills the color table by interpolating between @stops, as opaque
+ * ARGB32 pixels.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_fill_lut (UberHeatMap   *map,     /* IN */
+                        const guint32 *stops,   /* IN */
+                        guint          n_stops) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	guint32 pixel;
+	gdouble pos;
+	gdouble f;
+	guint stop;
+	guint shift;
+	guint i;
+
+	priv = map->priv;
+	for (i = 0; i < LUT_SIZE; i++) {
+		pos = i * (n_stops - 1) / (gdouble)(LUT_SIZE - 1);
+		stop = MIN((guint)pos, n_stops - 2);
+		f = pos - stop;
+		pixel = 0xFF000000;
+		for (shift = 0; shift < 24; shift += 8) {
+			pixel |= (guint32)((((stops[stop] >> shift) & 0xFF) * (1. - f)) +
+			                   (((stops[stop + 1] >> shift) & 0xFF) * f) +
+			                   .5) << shift;
+		}
+		priv->lut[i] = pixel;
+	}
+}
+
+/**
+ * uber_heat_map_update_lut:
+ * @map: A #UberHeatMap.
+ * @color: The foreground color.
+ *
+ * Fills the color table for the color map, as premultiplied ARGB32
+ * pixels.  The foreground color map is @color at every intensity.  Nothing
+ * is done if the table is already current.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_update_lut (UberHeatMap   *map,   /* IN */
+                          const GdkRGBA *color) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	gdouble a;
+	guint i;
+
+	priv = map->priv;
+	switch (priv->color_map) {
+	case UBER_HEAT_MAP_COLOR_MAP_VIRIDIS:
+		if (!priv->lut_valid) {
+			uber_heat_map_fill_lut(map, viridis_stops,
+			                       G_N_ELEMENTS(viridis_stops));
+		}
+		priv->lut_valid = TRUE;
+		return;
+	case UBER_HEAT_MAP_COLOR_MAP_MAGMA:
+		if (!priv->lut_valid) {
+			uber_heat_map_fill_lut(map, magma_stops,
+			                       G_N_ELEMENTS(magma_stops));
+		}
+		priv->lut_valid = TRUE;
+		return;
+	case UBER_HEAT_MAP_COLOR_MAP_GREYS:
+		if (!priv->lut_valid) {
+			uber_heat_map_fill_lut(map, greys_stops,
+			                       G_N_ELEMENTS(greys_stops));
+		}
+		priv->lut_valid = TRUE;
+		return;
+	case UBER_HEAT_MAP_COLOR_MAP_FG_COLOR:
+	default:
+		break;
+	}
+	if (priv->lut_valid && gdk_rgba_equal(&priv->lut_color, color)) {
+		return;
+	}
+	priv->lut_valid = TRUE;
+	priv->lut_color = *color;
+	for (i = 0; i < LUT_SIZE; i++) {
+		a = color->alpha * i / (gdouble)(LUT_SIZE - 1);
+		priv->lut[i] = ((guint32)(a * 255. + .5) << 24) |
+		               ((guint32)(color->red * a * 255. + .5) << 16) |
+		               ((guint32)(color->green * a * 255. + .5) << 8) |
+		               ((guint32)(color->blue * a * 255. + .5));
+	}
+}
+
+/**
+ * uber_heat_map_get_image:
+ * @map: A #UberHeatMap.
+ * @width: The number of columns.
+ *
+ * Retrieves an image surface with one pixel per bucket for @width
+ * columns.  The surface is kept for the next draw of the same width.
+ *
+ * Returns: A cairo image surface owned by @map.
+ * Side effects: None.
+ */
+static cairo_surface_t*
+uber_heat_map_get_image (UberHeatMap *map,   /* IN */
+                         guint        width) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	priv = map->priv;
+	if (priv->image &&
+	    cairo_image_surface_get_width(priv->image) == width &&
+	    cairo_image_surface_get_height(priv->image) == priv->n_buckets) {
+		return priv->image;
+	}
+	if (priv->image) {
+		cairo_surface_destroy(priv->image);
+	}
+	priv->image = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+	                                         width, priv->n_buckets);
+	return priv->image;
+}
+
+/**
+ * uber_heat_map_render_columns:
+ * @map: A #UberHeatMap.
+ * @cr: A #cairo_t.
+ * @area: The content area.
+ * @epoch: The right edge of the newest column.
+ * @each: The width of a column.
+ * @n_columns: The number of columns to draw, newest first.
+ *
+ * Draws the newest @n_columns columns, the first bucket at the bottom.
+ * Each bucket takes the color for its count relative to the largest count
+ * of its column, or of every column shown, depending on the normalization.
+ * Empty buckets are left clear.  The pixels of every column are written
+ * first and then scaled onto @cr at once.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_render_columns (UberHeatMap  *map,       /* IN */
+                              cairo_t      *cr,        /* IN */
+                              GdkRectangle *area,      /* IN */
+                              gdouble       epoch,     /* IN */
+                              gdouble       each,      /* IN */
+                              guint         n_columns) /* IN */
+{
+	UberHeatMapPrivate *priv;
+	cairo_surface_t *image;
+	cairo_pattern_t *pattern;
+	const guint32 *counts;
+	GdkRGBA color;
+	guint32 *pixel;
+	guint8 *data;
+	gint stride;
+	gdouble window_max = 0.;
+	gdouble log_scale = 0.;
+	guint32 max;
+	guint64 index;
+	guint i;
+	guint j;
+
+	priv = map->priv;
+	uber_heat_map_get_color(map, &color);
+	uber_heat_map_update_lut(map, &color);
+	image = uber_heat_map_get_image(map, n_columns);
+	cairo_surface_flush(image);
+	data = cairo_image_surface_get_data(image);
+	stride = cairo_image_surface_get_stride(image);
+	/*
+	 * Column i is at x = n_columns - 1 - i, and bucket j at the row
+	 * n_buckets - 1 - j, so the image reads oldest to newest and bottom
+	 * to top like the graph.
+	 */
+	if (priv->normalize != UBER_HEAT_MAP_NORMALIZE_COLUMN) {
+		uber_extrema_get(&priv->extrema, NULL, &window_max);
+		if (window_max > 0.) {
+			log_scale = (LUT_SIZE - 1) / log1p(window_max);
+		}
+	}
+	max = (guint32)window_max;
+	for (i = 0; i < n_columns; i++) {
+		counts = uber_heat_map_get_column(map, i);
+		if (priv->normalize == UBER_HEAT_MAP_NORMALIZE_COLUMN) {
+			max = 0;
+			for (j = 0; j < priv->n_buckets; j++) {
+				max = MAX(max, counts[j]);
+			}
+		}
+		pixel = (guint32 *)(data + ((priv->n_buckets - 1) * stride))
+		      + (n_columns - 1 - i);
+		for (j = 0; j < priv->n_buckets; j++) {
+			if (!counts[j] || !max) {
+				*pixel = 0;
+			} else {
+				if (priv->normalize == UBER_HEAT_MAP_NORMALIZE_LOG) {
+					index = (guint64)(log1p(counts[j]) * log_scale);
+				} else {
+					index = ((guint64)counts[j] * (LUT_SIZE - 1)) / max;
+				}
+				*pixel = priv->lut[CLAMP(index, 1, LUT_SIZE - 1)];
+			}
+			pixel = (guint32 *)((guint8 *)pixel - stride);
+		}
+	}
+	cairo_surface_mark_dirty(image);
+	/*
+	 * Stretch the image over the columns, keeping bucket edges sharp.
+	 */
+	cairo_save(cr);
+	cairo_translate(cr, epoch - (n_columns * each), area->y);
+	cairo_scale(cr, each, area->height / (gdouble)priv->n_buckets);
+	cairo_set_source_surface(cr, image, 0, 0);
+	pattern = cairo_get_source(cr);
+	cairo_pattern_set_filter(pattern, CAIRO_FILTER_NEAREST);
+	cairo_rectangle(cr, 0, 0, n_columns, priv->n_buckets);
+	cairo_fill(cr);
+	cairo_restore(cr);
+}
+
 /**
  * uber_heat_map_render:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Draws every column, the newest ending at @epoch.
  *
  * Returns: None.
  * Side effects: None.
@@ -150,35 +776,23 @@ uber_heat_map_render (UberGraph    *graph, /* IN */
                       guint         epoch, /* IN */
                       gfloat        each)  /* IN */
 {
-#if 0
-	UberGraphPrivate *priv;
-	cairo_pattern_t *cp;
+	UberHeatMapPrivate *priv;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(graph));
 
-	priv = graph->priv;
-	/*
-	 * XXX: Temporarily draw a nice little gradient to test sliding.
-	 */
-	cp = cairo_pattern_create_linear(0, 0, area->width, 0);
-	cairo_pattern_add_color_stop_rgb(cp, 0, .1, .1, .1);
-	cairo_pattern_add_color_stop_rgb(cp, .2, .3, .3, .5);
-	cairo_pattern_add_color_stop_rgb(cp, .4, .2, .7, .4);
-	cairo_pattern_add_color_stop_rgb(cp, .7, .6, .2, .1);
-	cairo_pattern_add_color_stop_rgb(cp, .8, .6, .8, .1);
-	cairo_pattern_add_color_stop_rgb(cp, 1., .3, .8, .5);
-	gdk_cairo_rectangle(cr, area);
-	cairo_set_source(cr, cp);
-	cairo_fill(cr);
-	cairo_pattern_destroy(cp);
-#endif
+	priv = UBER_HEAT_MAP(graph)->priv;
+	if (!priv->columns || !priv->columns->len) {
+		return;
+	}
+	uber_heat_map_render_columns(UBER_HEAT_MAP(graph), cr, area, epoch, each,
+	                             priv->columns->len);
 }
 
 /**
  * uber_heat_map_render_fast:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Draws the newest column, ending at @epoch.
  *
  * Returns: None.
  * Side effects: None.
@@ -191,47 +805,24 @@ uber_heat_map_render_fast (UberGraph    *graph, /* IN */
                            gfloat        each)  /* IN */
 {
 	UberHeatMapPrivate *priv;
-	GtkStyleContext *style;
-	GdkRGBA color;
-	gfloat height;
-	gint i;
 
 	g_return_if_fail(UBER_IS_HEAT_MAP(graph));
 
 	priv = UBER_HEAT_MAP(graph)->priv;
-	color = priv->fg_color;
-	if (!priv->fg_color_set) {
-		style = gtk_widget_get_style_context(GTK_WIDGET(graph));
-		gtk_style_context_get_color(style, GTK_STATE_FLAG_SELECTED, &color);
-	}
-	/*
-	 * XXX: Temporarily draw nice little squares.
-	 */
-	#define COUNT 10
-	height = area->height / (gfloat)COUNT;
-	for (i = 0; i < COUNT; i++) {
-		cairo_rectangle(cr,
-		                area->x + area->width - each,
-		                area->y + (i * height),
-		                each,
-		                height);
-		cairo_set_source_rgba(cr,
-		                      color.red,
-		                      color.green,
-		                      color.blue,
-		                      g_random_double_range(0., 1.));
-		cairo_set_antialias(cr, CAIRO_ANTIALIAS_NONE);
-		cairo_fill(cr);
+	if (!priv->columns || !priv->columns->len) {
+		return;
 	}
+	uber_heat_map_render_columns(UBER_HEAT_MAP(graph), cr, area, epoch, each,
+	                             1);
 }
 
 /**
  * uber_heat_map_get_next_data:
  * @graph: A #UberGraph.
  *
- * Retrieve the next data point for the graph.
+ * Gathers the values for this tick into a new histogram and column.
  *
- * Returns: None.
+ * Returns: %TRUE if any values were counted.
  * Side effects: None.
  */
 static gboolean
@@ -239,27 +830,53 @@ uber_heat_map_get_next_data (UberGraph *graph) /* IN */
 {
 	UberHeatMapPrivate *priv;
 	GArray *array = NULL;
+	guint32 *counts;
+	guint64 n_counted;
+	gdouble old_max = 0.;
+	gdouble new_max = 0.;
+	guint i;
 
 	g_return_val_if_fail(UBER_IS_HEAT_MAP(graph), FALSE);
 
 	priv = UBER_HEAT_MAP(graph)->priv;
-	if (!priv->func) {
+	if ((!priv->func && !priv->histogram_func) || !priv->sketches) {
 		return FALSE;
 	}
 	/*
-	 * Retrieve the next data point.
+	 * Gather the values of this tick.  Every tick gets a column, even when
+	 * there are no values, so that columns stay in step with the graph.
 	 */
-	if (!priv->func(UBER_HEAT_MAP(graph), &array, priv->func_user_data)) {
-		return FALSE;
+	uber_histogram_clear(priv->sketch);
+	if (priv->histogram_func) {
+		priv->histogram_func(UBER_HEAT_MAP(graph), priv->sketch,
+		                     priv->histogram_func_user_data);
+	} else if (priv->func(UBER_HEAT_MAP(graph), &array,
+	                      priv->func_user_data) && array) {
+		for (i = 0; i < array->len; i++) {
+			uber_histogram_record(priv->sketch,
+			                      g_array_index(array, gdouble, i));
+		}
+	}
+	if (array) {
+		g_array_unref(array);
 	}
+	g_ring_append_vals(priv->sketches, priv->sketch, 1);
+	counts = g_new(guint32, priv->n_buckets);
+	n_counted = uber_heat_map_count(UBER_HEAT_MAP(graph), priv->sketch,
+	                                counts);
+	uber_extrema_get(&priv->extrema, NULL, &old_max);
+	uber_heat_map_push_column(UBER_HEAT_MAP(graph), counts);
+	uber_extrema_get(&priv->extrema, NULL, &new_max);
+	g_free(counts);
 	/*
-	 * Store data points.
+	 * Columns already drawn were colored against the old maximum of the
+	 * window, so they must be drawn again when it moves.
 	 */
-	g_ring_append_val(priv->raw_data, array);
-//	for (int i = 0; i < array->len; i++) {
-//		g_print("==> %f\n", g_array_index(array, gdouble, i));
-//	}
-	return TRUE;
+	if (new_max != old_max &&
+	    priv->normalize != UBER_HEAT_MAP_NORMALIZE_COLUMN) {
+		uber_graph_redraw(graph);
+	}
+	return (n_counted > 0);
 }
 
 /**
@@ -289,6 +906,283 @@ uber_heat_map_set_fg_color (UberHeatMap    *map,   /* IN */
 	}
 }
 
+/**
+ * uber_heat_map_get_color_map:
+ * @map: A #UberHeatMap.
+ *
+ * Retrieves the colors that bucket counts are drawn with.
+ *
+ * Returns: An #UberHeatMapColorMap.
+ * Side effects: None.
+ */
+UberHeatMapColorMap
+uber_heat_map_get_color_map (UberHeatMap *map) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map),
+	                     UBER_HEAT_MAP_COLOR_MAP_FG_COLOR);
+	return map->priv->color_map;
+}
+
+/**
+ * uber_heat_map_set_color_map:
+ * @map: A #UberHeatMap.
+ * @color_map: An #UberHeatMapColorMap.
+ *
+ * Sets the colors that bucket counts are drawn with.  The default,
+ * %UBER_HEAT_MAP_COLOR_MAP_FG_COLOR, draws the foreground color more
+ * opaque for larger counts.  The other maps go from dark to bright, or
+ * light to dark for %UBER_HEAT_MAP_COLOR_MAP_GREYS, and are easier to read
+ * bands from.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_color_map (UberHeatMap         *map,       /* IN */
+                             UberHeatMapColorMap  color_map) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(color_map <= UBER_HEAT_MAP_COLOR_MAP_GREYS);
+
+	priv = map->priv;
+	if (priv->color_map != color_map) {
+		priv->color_map = color_map;
+		priv->lut_valid = FALSE;
+		uber_graph_redraw(UBER_GRAPH(map));
+	}
+}
+
+/**
+ * uber_heat_map_get_normalize:
+ * @map: A #UberHeatMap.
+ *
+ * Retrieves how bucket counts are scaled to colors.
+ *
+ * Returns: An #UberHeatMapNormalize.
+ * Side effects: None.
+ */
+UberHeatMapNormalize
+uber_heat_map_get_normalize (UberHeatMap *map) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map),
+	                     UBER_HEAT_MAP_NORMALIZE_COLUMN);
+	return map->priv->normalize;
+}
+
+/**
+ * uber_heat_map_set_normalize:
+ * @map: A #UberHeatMap.
+ * @normalize: An #UberHeatMapNormalize.
+ *
+ * Sets how bucket counts are scaled to colors.  With
+ * %UBER_HEAT_MAP_NORMALIZE_COLUMN, the default, the largest count of each
+ * column gets the last color.  %UBER_HEAT_MAP_NORMALIZE_WINDOW uses the
+ * largest count of any column shown instead, so columns can be compared.
+ * %UBER_HEAT_MAP_NORMALIZE_LOG does the same on a logarithmic scale, which
+ * keeps small counts visible next to large ones.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_normalize (UberHeatMap          *map,       /* IN */
+                             UberHeatMapNormalize  normalize) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(normalize <= UBER_HEAT_MAP_NORMALIZE_LOG);
+
+	priv = map->priv;
+	if (priv->normalize != normalize) {
+		priv->normalize = normalize;
+		uber_graph_redraw(UBER_GRAPH(map));
+	}
+}
+
+/**
+ * uber_heat_map_get_n_buckets:
+ * @map: A #UberHeatMap.
+ *
+ * Retrieves the number of buckets in each column.
+ *
+ * Returns: The number of buckets.
+ * Side effects: None.
+ */
+guint
+uber_heat_map_get_n_buckets (UberHeatMap *map) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map), 0);
+	return map->priv->n_buckets;
+}
+
+/**
+ * uber_heat_map_set_n_buckets:
+ * @map: A #UberHeatMap.
+ * @n_buckets: The number of buckets.
+ *
+ * Sets the number of buckets that the range is divided into.  Columns
+ * already collected are rebuilt from the histograms of their ticks.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_n_buckets (UberHeatMap *map,       /* IN */
+                             guint        n_buckets) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(n_buckets > 0);
+
+	priv = map->priv;
+	if (priv->n_buckets != n_buckets) {
+		priv->n_buckets = n_buckets;
+		uber_heat_map_reset_columns(map);
+		uber_graph_redraw(UBER_GRAPH(map));
+	}
+}
+
+/**
+ * uber_heat_map_get_range:
+ * @map: A #UberHeatMap.
+ *
+ * Retrieves the range of values covered by the buckets.
+ *
+ * Returns: An #UberRange which should not be modified or freed.
+ * Side effects: None.
+ */
+const UberRange*
+uber_heat_map_get_range (UberHeatMap *map) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_HEAT_MAP(map), NULL);
+	return &map->priv->range;
+}
+
+/**
+ * uber_heat_map_set_range:
+ * @map: A #UberHeatMap.
+ * @range: An #UberRange.
+ *
+ * Sets the range of values covered by the buckets.  Columns already
+ * collected are rebuilt from the histograms of their ticks.
+ *
+ * The histograms start at zero, so @range must not begin below zero.
+ * Negative values are counted in the first bucket, like any other value
+ * below the range.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_range (UberHeatMap     *map,   /* IN */
+                         const UberRange *range) /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+	g_return_if_fail(range != NULL);
+	g_return_if_fail(range->begin >= 0.);
+	g_return_if_fail(range->end > range->begin);
+
+	priv = map->priv;
+	priv->range = *range;
+	priv->range.range = priv->range.end - priv->range.begin;
+	uber_heat_map_reset_columns(map);
+	uber_graph_scale_changed(UBER_GRAPH(map));
+}
+
+/**
+ * uber_heat_map_set_scale:
+ * @map: A #UberHeatMap.
+ * @scale: An #UberScale, or %NULL for uber_scale_linear().
+ * @scale_batch: The #UberScaleBatch equivalent of @scale, or %NULL.
+ * @user_data: user data for @scale and @scale_batch.
+ * @notify: A #GDestroyNotify for @user_data, or %NULL.
+ *
+ * Sets how the buckets are spaced across the range.  With uber_scale_log()
+ * each bucket covers the same ratio of values rather than the same
+ * difference.  Columns already collected are rebuilt from the histograms
+ * of their ticks.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_heat_map_set_scale (UberHeatMap    *map,         /* IN */
+                         UberScale       scale,       /* IN */
+                         UberScaleBatch  scale_batch, /* IN */
+                         gpointer        user_data,   /* IN */
+                         GDestroyNotify  notify)      /* IN */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(map));
+
+	priv = map->priv;
+	if (priv->scale_notify) {
+		priv->scale_notify(priv->scale_data);
+	}
+	if (!scale) {
+		scale = uber_scale_linear;
+		scale_batch = uber_scale_linear_batch;
+	}
+	priv->scale = scale;
+	priv->scale_batch = scale_batch;
+	priv->scale_data = user_data;
+	priv->scale_notify = notify;
+	uber_heat_map_reset_columns(map);
+	uber_graph_scale_changed(UBER_GRAPH(map));
+}
+
+/**
+ * uber_heat_map_get_yrange:
+ * @graph: A #UberGraph.
+ * @range: (out): A location for the range.
+ *
+ * Retrieves the range of values shown vertically.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_yrange (UberGraph *graph, /* IN */
+                          UberRange *range) /* OUT */
+{
+	g_return_if_fail(UBER_IS_HEAT_MAP(graph));
+	g_return_if_fail(range != NULL);
+
+	*range = UBER_HEAT_MAP(graph)->priv->range;
+}
+
+/**
+ * uber_heat_map_get_yscale:
+ * @graph: A #UberGraph.
+ * @scale: (out): A location for the #UberScale.
+ * @scale_data: (out): A location for the user data of @scale.
+ *
+ * Retrieves the scale the buckets are spaced by.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_heat_map_get_yscale (UberGraph *graph,      /* IN */
+                          UberScale *scale,      /* OUT */
+                          gpointer  *scale_data) /* OUT */
+{
+	UberHeatMapPrivate *priv;
+
+	g_return_if_fail(UBER_IS_HEAT_MAP(graph));
+
+	priv = UBER_HEAT_MAP(graph)->priv;
+	*scale = priv->scale;
+	*scale_data = priv->scale_data;
+}
+
 /**
  * uber_heat_map_finalize:
  * @object: A #UberHeatMap.
@@ -302,6 +1196,34 @@ uber_heat_map_set_fg_color (UberHeatMap    *map,   /* IN */
 static void
 uber_heat_map_finalize (GObject *object) /* IN */
 {
+	UberHeatMapPrivate *priv;
+
+	priv = UBER_HEAT_MAP(object)->priv;
+	/*
+	 * Release the stored columns.
+	 */
+	if (priv->columns) {
+		g_ring_unref(priv->columns);
+	}
+	if (priv->sketches) {
+		g_ring_unref(priv->sketches);
+	}
+	uber_histogram_free(priv->sketch);
+	uber_histogram_free(priv->merged);
+	uber_extrema_destroy(&priv->extrema);
+	g_free(priv->bucket_edges);
+	if (priv->image) {
+		cairo_surface_destroy(priv->image);
+	}
+	if (priv->func_destroy) {
+		priv->func_destroy(priv->func_user_data);
+	}
+	if (priv->histogram_func_destroy) {
+		priv->histogram_func_destroy(priv->histogram_func_user_data);
+	}
+	if (priv->scale_notify) {
+		priv->scale_notify(priv->scale_data);
+	}
 	G_OBJECT_CLASS(uber_heat_map_parent_class)->finalize(object);
 }
 
@@ -329,6 +1251,8 @@ uber_heat_map_class_init (UberHeatMapClass *klass) /* IN */
 	graph_class->render_fast = uber_heat_map_render_fast;
 	graph_class->set_stride = uber_heat_map_set_stride;
 	graph_class->get_next_data = uber_heat_map_get_next_data;
+	graph_class->get_yrange = uber_heat_map_get_yrange;
+	graph_class->get_yscale = uber_heat_map_get_yscale;
 }
 
 /**
@@ -343,7 +1267,23 @@ uber_heat_map_class_init (UberHeatMapClass *klass) /* IN */
 static void
 uber_heat_map_init (UberHeatMap *map) /* IN */
 {
+	UberHeatMapPrivate *priv;
+
 	map->priv = G_TYPE_INSTANCE_GET_PRIVATE(map,
 	                                        UBER_TYPE_HEAT_MAP,
 	                                        UberHeatMapPrivate);
+	priv = map->priv;
+
+	priv->n_buckets = DEFAULT_BUCKETS;
+	priv->range.begin = 0.;
+	priv->range.end = 100.;
+	priv->range.range = priv->range.end - priv->range.begin;
+	priv->scale = uber_scale_linear;
+	priv->scale_batch = uber_scale_linear_batch;
+	priv->sketch = uber_histogram_new(UBER_HEAT_MAP_HISTOGRAM_LOWEST,
+	                                  UBER_HEAT_MAP_HISTOGRAM_HIGHEST,
+	                                  UBER_HEAT_MAP_HISTOGRAM_PRECISION);
+	priv->merged = uber_histogram_copy(priv->sketch);
+	uber_extrema_init(&priv->extrema);
+	uber_heat_map_update_bucket_edges(map);
 }
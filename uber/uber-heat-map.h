@@ -20,6 +20,7 @@
 #define __UBER_HEAT_MAP_H__
 
 #include "uber-graph.h"
+#include "uber-histogram.h"
 
 G_BEGIN_DECLS
 
@@ -31,14 +32,66 @@ G_BEGIN_DECLS
 #define UBER_IS_HEAT_MAP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass),  UBER_TYPE_HEAT_MAP))
 #define UBER_HEAT_MAP_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj),  UBER_TYPE_HEAT_MAP, UberHeatMapClass))
 
+/*
+ * Layout of the histograms kept for each tick.  Histograms passed to
+ * uber_heat_map_set_histogram_func() callbacks are created this way, and
+ * histograms merged into them must be too.
+ */
+#define UBER_HEAT_MAP_HISTOGRAM_LOWEST    (1e-3)
+#define UBER_HEAT_MAP_HISTOGRAM_HIGHEST   (1e9)
+#define UBER_HEAT_MAP_HISTOGRAM_PRECISION (4)
+
+typedef enum
+{
+	UBER_HEAT_MAP_COLOR_MAP_FG_COLOR,
+	UBER_HEAT_MAP_COLOR_MAP_VIRIDIS,
+	UBER_HEAT_MAP_COLOR_MAP_MAGMA,
+	UBER_HEAT_MAP_COLOR_MAP_GREYS,
+} UberHeatMapColorMap;
+
+typedef enum
+{
+	UBER_HEAT_MAP_NORMALIZE_COLUMN,
+	UBER_HEAT_MAP_NORMALIZE_WINDOW,
+	UBER_HEAT_MAP_NORMALIZE_LOG,
+} UberHeatMapNormalize;
+
 typedef struct _UberHeatMap        UberHeatMap;
 typedef struct _UberHeatMapClass   UberHeatMapClass;
 typedef struct _UberHeatMapPrivate UberHeatMapPrivate;
 
+/**
+ * UberHeatMapFunc:
+ * @map: A #UberHeatMap.
+ * @values: (out): A location for a #GArray of #gdouble.
+ * @user_data: User data supplied to uber_heat_map_set_data_func().
+ *
+ * Callback prototype for retrieving the values of the next data tick.
+ * The heat map takes ownership of the array and releases it once the
+ * values have been counted.
+ *
+ * Returns: %TRUE if @values was set.
+ * Side effects: Implementation dependent.
+ */
 typedef gboolean (*UberHeatMapFunc) (UberHeatMap  *map,
                                      GArray      **values,
                                      gpointer      user_data);
 
+/**
+ * UberHeatMapHistogramFunc:
+ * @map: A #UberHeatMap.
+ * @histogram: An empty #UberHistogram to record the values into.
+ * @user_data: User data supplied to uber_heat_map_set_histogram_func().
+ *
+ * Callback prototype for recording the values of the next data tick.
+ *
+ * Returns: %TRUE if values were recorded.
+ * Side effects: Implementation dependent.
+ */
+typedef gboolean (*UberHeatMapHistogramFunc) (UberHeatMap   *map,
+                                              UberHistogram *histogram,
+                                              gpointer       user_data);
+
 struct _UberHeatMap
 {
 	UberGraph parent;
@@ -52,14 +105,39 @@ struct _UberHeatMapClass
 	UberGraphClass parent_class;
 };
 
-GType      uber_heat_map_get_type      (void) G_GNUC_CONST;
-GtkWidget* uber_heat_map_new           (void);
-void       uber_heat_map_set_fg_color  (UberHeatMap     *map,
-                                        const GdkRGBA   *color);
-void       uber_heat_map_set_data_func (UberHeatMap     *map,
-                                        UberHeatMapFunc  func,
-                                        gpointer         user_data,
-                                        GDestroyNotify   destroy);
+GType            uber_heat_map_get_type      (void) G_GNUC_CONST;
+GtkWidget*       uber_heat_map_new           (void);
+void             uber_heat_map_set_fg_color  (UberHeatMap     *map,
+                                              const GdkRGBA   *color);
+UberHeatMapColorMap  uber_heat_map_get_color_map (UberHeatMap          *map);
+void                 uber_heat_map_set_color_map (UberHeatMap          *map,
+                                                  UberHeatMapColorMap   color_map);
+UberHeatMapNormalize uber_heat_map_get_normalize (UberHeatMap          *map);
+void                 uber_heat_map_set_normalize (UberHeatMap          *map,
+                                                  UberHeatMapNormalize  normalize);
+void             uber_heat_map_set_data_func (UberHeatMap     *map,
+                                              UberHeatMapFunc  func,
+                                              gpointer         user_data,
+                                              GDestroyNotify   destroy);
+void             uber_heat_map_set_histogram_func (UberHeatMap              *map,
+                                                   UberHeatMapHistogramFunc  func,
+                                                   gpointer                  user_data,
+                                                   GDestroyNotify            destroy);
+gdouble          uber_heat_map_get_quantile  (UberHeatMap     *map,
+                                              guint            first,
+                                              guint            n_ticks,
+                                              gdouble          quantile);
+guint            uber_heat_map_get_n_buckets (UberHeatMap     *map);
+void             uber_heat_map_set_n_buckets (UberHeatMap     *map,
+                                              guint            n_buckets);
+const UberRange* uber_heat_map_get_range     (UberHeatMap     *map);
+void             uber_heat_map_set_range     (UberHeatMap     *map,
+                                              const UberRange *range);
+void             uber_heat_map_set_scale     (UberHeatMap     *map,
+                                              UberScale        scale,
+                                              UberScaleBatch   scale_batch,
+                                              gpointer         user_data,
+                                              GDestroyNotify   notify);
 
 G_END_DECLS
 
@@ -0,0 +1,417 @@
+/* uber-histogram.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "uber-histogram.h"
+
+/**
+ * SECTION:uber-histogram
+ * @title: UberHistogram
+ * @short_description: Fixed size, mergeable value distributions.
+ *
+ * An #UberHistogram counts values into log-linear buckets.  Each power of
+ * two above the lowest value is split into 2^precision equal buckets, so
+ * every bucket is narrower than 1/2^precision of the values it holds.
+ * Values below the lowest value share the first bucket and values above
+ * the highest value are counted in the last.
+ *
+ * The size of a histogram only depends on how it was created, not on how
+ * many values it counts.  Histograms created alike can be merged, which
+ * gives the distribution of the union of their values.
+ *
+ * A histogram is a single block of memory without pointers, so it may be
+ * copied with memcpy() using uber_histogram_get_size().
+ */
+
+#define MAX_PRECISION (10)
+
+struct _UberHistogram
+{
+	gdouble lowest;    /* Upper bound of the first bucket. */
+	guint   precision; /* Bits of sub-buckets per power of two. */
+	guint   n_buckets; /* Number of counts. */
+	guint64 total;     /* Sum of counts. */
+	gdouble min;       /* Smallest value recorded. */
+	gdouble max;       /* Largest value recorded. */
+	guint32 counts[1];
+};
+
+/**
+ * uber_histogram_get_index:
+ * @histogram: An #UberHistogram.
+ * @value: A value.
+ *
+ * Finds the bucket that @value is counted in.
+ *
+ * Returns: The bucket index.
+ * Side effects: None.
+ */
+static inline guint
+uber_histogram_get_index (const UberHistogram *histogram, /* IN */
+                          gdouble              value)     /* IN */
+{
+	gdouble mantissa;
+	guint index;
+	gint exp;
+
+	if (!(value >= histogram->lowest)) {
+		return 0;
+	}
+	/*
+	 * value / lowest = mantissa * 2^exp, with mantissa in [0.5, 1).  The
+	 * power of two picks the group of sub-buckets and the mantissa picks
+	 * the sub-bucket within it.
+	 */
+	mantissa = frexp(value / histogram->lowest, &exp);
+	index = 1 + ((exp - 1) << histogram->precision)
+	      + (guint)((mantissa * 2. - 1.) * (1 << histogram->precision));
+	return MIN(index, histogram->n_buckets - 1);
+}
+
+/**
+ * uber_histogram_new:
+ * @lowest: The smallest value to tell apart, above zero.
+ * @highest: The largest value to tell apart.
+ * @precision: Sub-buckets per power of two, as a power of two.
+ *
+ * Creates a new #UberHistogram.  Values between @lowest and @highest are
+ * counted into buckets no wider than 1/2^@precision of their values, so
+ * a @precision of 4 gives quantiles within about 6%.
+ *
+ * Returns: A new #UberHistogram which should be freed with
+ *   uber_histogram_free().
+ * Side effects: None.
+ */
+UberHistogram*
+uber_histogram_new (gdouble lowest,    /* IN */
+                    gdouble highest,   /* IN */
+                    guint   precision) /* IN */
+{
+	UberHistogram *histogram;
+	guint n_powers;
+	guint n_buckets;
+
+	g_return_val_if_fail(lowest > 0., NULL);
+	g_return_val_if_fail(highest > lowest, NULL);
+	g_return_val_if_fail(precision <= MAX_PRECISION, NULL);
+
+	n_powers = (guint)ceil(log2(highest / lowest)) + 1;
+	n_buckets = 1 + (n_powers << precision);
+	histogram = g_malloc0(G_STRUCT_OFFSET(UberHistogram, counts) +
+	                      (sizeof(guint32) * n_buckets));
+	histogram->lowest = lowest;
+	histogram->precision = precision;
+	histogram->n_buckets = n_buckets;
+	uber_histogram_clear(histogram);
+	return histogram;
+}
+
+/**
+ * uber_histogram_get_size:
+ * @histogram: An #UberHistogram.
+ *
+ * Retrieves the number of bytes used by @histogram.
+ *
+ * Returns: The size in bytes.
+ * Side effects: None.
+ */
+gsize
+uber_histogram_get_size (const UberHistogram *histogram) /* IN */
+{
+	g_return_val_if_fail(histogram != NULL, 0);
+
+	return G_STRUCT_OFFSET(UberHistogram, counts) +
+	       (sizeof(guint32) * histogram->n_buckets);
+}
+
+/**
+ * uber_histogram_copy:
+ * @histogram: An #UberHistogram.
+ *
+ * Copies @histogram, including its counts.
+ *
+ * Returns: A new #UberHistogram which should be freed with
+ *   uber_histogram_free().
+ * Side effects: None.
+ */
+UberHistogram*
+uber_histogram_copy (const UberHistogram *histogram) /* IN */
+{
+	UberHistogram *copy;
+	gsize size;
+
+	g_return_val_if_fail(histogram != NULL, NULL);
+
+	size = uber_histogram_get_size(histogram);
+	copy = g_malloc(size);
+	memcpy(copy, histogram, size);
+	return copy;
+}
+
+/**
+ * uber_histogram_free:
+ * @histogram: An #UberHistogram.
+ *
+ * Frees @histogram.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_histogram_free (UberHistogram *histogram) /* IN */
+{
+	g_free(histogram);
+}
+
+/**
+ * uber_histogram_clear:
+ * @histogram: An #UberHistogram.
+ *
+ * Removes every value from @histogram.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_histogram_clear (UberHistogram *histogram) /* IN */
+{
+	g_return_if_fail(histogram != NULL);
+
+	memset(histogram->counts, 0, sizeof(guint32) * histogram->n_buckets);
+	histogram->total = 0;
+	histogram->min = G_MAXDOUBLE;
+	histogram->max = -G_MAXDOUBLE;
+}
+
+/**
+ * uber_histogram_record_n:
+ * @histogram: An #UberHistogram.
+ * @value: The value.
+ * @count: The number of times @value was seen.
+ *
+ * Counts @value @count times.  %NAN is ignored.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_histogram_record_n (UberHistogram *histogram, /* IN */
+                         gdouble        value,     /* IN */
+                         guint32        count)     /* IN */
+{
+	guint32 *bucket;
+
+	g_return_if_fail(histogram != NULL);
+
+	if (isnan(value) || !count) {
+		return;
+	}
+	/*
+	 * Counts saturate rather than wrap.
+	 */
+	bucket = &histogram->counts[uber_histogram_get_index(histogram, value)];
+	*bucket = (*bucket > G_MAXUINT32 - count) ? G_MAXUINT32 : *bucket + count;
+	histogram->total += count;
+	histogram->min = MIN(histogram->min, value);
+	histogram->max = MAX(histogram->max, value);
+}
+
+/**
+ * uber_histogram_record:
+ * @histogram: An #UberHistogram.
+ * @value: The value.
+ *
+ * Counts @value once.  %NAN is ignored.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_histogram_record (UberHistogram *histogram, /* IN */
+                       gdouble        value)     /* IN */
+{
+	uber_histogram_record_n(histogram, value, 1);
+}
+
+/**
+ * uber_histogram_merge:
+ * @histogram: An #UberHistogram.
+ * @other: An #UberHistogram created like @histogram.
+ *
+ * Adds the counts of @other to @histogram.
+ *
+ * Returns: %TRUE if the histograms were created alike and were merged.
+ * Side effects: None.
+ */
+gboolean
+uber_histogram_merge (UberHistogram       *histogram, /* IN */
+                      const UberHistogram *other)     /* IN */
+{
+	guint i;
+
+	g_return_val_if_fail(histogram != NULL, FALSE);
+	g_return_val_if_fail(other != NULL, FALSE);
+
+	if (histogram->lowest != other->lowest ||
+	    histogram->precision != other->precision ||
+	    histogram->n_buckets != other->n_buckets) {
+		return FALSE;
+	}
+	for (i = 0; i < histogram->n_buckets; i++) {
+		histogram->counts[i] =
+			(histogram->counts[i] > G_MAXUINT32 - other->counts[i]) ?
+			G_MAXUINT32 : histogram->counts[i] + other->counts[i];
+	}
+	histogram->total += other->total;
+	histogram->min = MIN(histogram->min, other->min);
+	histogram->max = MAX(histogram->max, other->max);
+	return TRUE;
+}
+
+/**
+ * uber_histogram_get_count:
+ * @histogram: An #UberHistogram.
+ *
+ * Retrieves the number of values recorded.
+ *
+ * Returns: The number of values.
+ * Side effects: None.
+ */
+guint64
+uber_histogram_get_count (const UberHistogram *histogram) /* IN */
+{
+	g_return_val_if_fail(histogram != NULL, 0);
+	return histogram->total;
+}
+
+/**
+ * uber_histogram_get_n_buckets:
+ * @histogram: An #UberHistogram.
+ *
+ * Retrieves the number of buckets in @histogram.
+ *
+ * Returns: The number of buckets.
+ * Side effects: None.
+ */
+guint
+uber_histogram_get_n_buckets (const UberHistogram *histogram) /* IN */
+{
+	g_return_val_if_fail(histogram != NULL, 0);
+	return histogram->n_buckets;
+}
+
+/**
+ * uber_histogram_get_bucket:
+ * @histogram: An #UberHistogram.
+ * @bucket: The bucket index.
+ * @low: (out) (allow-none): A location for the lowest value of the bucket.
+ * @high: (out) (allow-none): A location for the end of the bucket.
+ *
+ * Retrieves the count of a bucket and the values it covers.  The first
+ * bucket covers values from zero to the lowest value.
+ *
+ * Returns: The number of values counted in @bucket.
+ * Side effects: None.
+ */
+guint32
+uber_histogram_get_bucket (const UberHistogram *histogram, /* IN */
+                           guint                bucket,    /* IN */
+                           gdouble             *low,       /* OUT */
+                           gdouble             *high)      /* OUT */
+{
+	gdouble base;
+	guint sub;
+
+	g_return_val_if_fail(histogram != NULL, 0);
+	g_return_val_if_fail(bucket < histogram->n_buckets, 0);
+
+	if (!bucket) {
+		if (low) {
+			*low = 0.;
+		}
+		if (high) {
+			*high = histogram->lowest;
+		}
+		return histogram->counts[0];
+	}
+	base = ldexp(histogram->lowest, (bucket - 1) >> histogram->precision);
+	sub = (bucket - 1) & ((1 << histogram->precision) - 1);
+	if (low) {
+		*low = base * (1. + ldexp(sub, -(gint)histogram->precision));
+	}
+	if (high) {
+		*high = base * (1. + ldexp(sub + 1, -(gint)histogram->precision));
+	}
+	return histogram->counts[bucket];
+}
+
+/**
+ * uber_histogram_get_quantile:
+ * @histogram: An #UberHistogram.
+ * @quantile: The quantile, between 0 and 1.
+ *
+ * Estimates the value below which @quantile of the recorded values fall.
+ * The estimate is the middle of the bucket holding that value, kept within
+ * the smallest and largest values recorded.
+ *
+ * Returns: The value at @quantile, or %NAN if nothing was recorded.
+ * Side effects: None.
+ */
+gdouble
+uber_histogram_get_quantile (const UberHistogram *histogram, /* IN */
+                             gdouble              quantile)  /* IN */
+{
+	guint64 rank;
+	guint64 seen = 0;
+	gdouble low;
+	gdouble high;
+	guint i;
+
+	g_return_val_if_fail(histogram != NULL, NAN);
+
+	if (!histogram->total) {
+		return NAN;
+	}
+	rank = (guint64)ceil(CLAMP(quantile, 0., 1.) * histogram->total);
+	rank = MAX(rank, 1);
+	for (i = 0; i < histogram->n_buckets; i++) {
+		seen += histogram->counts[i];
+		if (seen >= rank) {
+			break;
+		}
+	}
+	i = MIN(i, histogram->n_buckets - 1);
+	uber_histogram_get_bucket(histogram, i, &low, &high);
+	return CLAMP((low + high) / 2., histogram->min, histogram->max);
+}
+
+GType
+uber_histogram_get_type (void)
+{
+	static gsize type_id = 0;
+
+	if (g_once_init_enter(&type_id)) {
+		g_once_init_leave(&type_id,
+		                  g_boxed_type_register_static("UberHistogram",
+		                                               (GBoxedCopyFunc)uber_histogram_copy,
+		                                               (GBoxedFreeFunc)uber_histogram_free));
+	}
+	return type_id;
+}
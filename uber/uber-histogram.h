@@ -0,0 +1,62 @@
+/* uber-histogram.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_HISTOGRAM_H__
+#define __UBER_HISTOGRAM_H__
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define UBER_TYPE_HISTOGRAM (uber_histogram_get_type())
+
+/**
+ * UberHistogram:
+ *
+ * #UberHistogram is a fixed size sketch of how a set of non-negative
+ * values is distributed.  See uber_histogram_new().
+ */
+typedef struct _UberHistogram UberHistogram;
+
+GType          uber_histogram_get_type      (void) G_GNUC_CONST;
+UberHistogram* uber_histogram_new           (gdouble              lowest,
+                                             gdouble              highest,
+                                             guint                precision);
+UberHistogram* uber_histogram_copy          (const UberHistogram *histogram);
+void           uber_histogram_free          (UberHistogram       *histogram);
+gsize          uber_histogram_get_size      (const UberHistogram *histogram);
+void           uber_histogram_clear         (UberHistogram       *histogram);
+void           uber_histogram_record        (UberHistogram       *histogram,
+                                             gdouble              value);
+void           uber_histogram_record_n      (UberHistogram       *histogram,
+                                             gdouble              value,
+                                             guint32              count);
+gboolean       uber_histogram_merge         (UberHistogram       *histogram,
+                                             const UberHistogram *other);
+guint64        uber_histogram_get_count     (const UberHistogram *histogram);
+gdouble        uber_histogram_get_quantile  (const UberHistogram *histogram,
+                                             gdouble              quantile);
+guint          uber_histogram_get_n_buckets (const UberHistogram *histogram);
+guint32        uber_histogram_get_bucket    (const UberHistogram *histogram,
+                                             guint                bucket,
+                                             gdouble             *low,
+                                             gdouble             *high);
+
+G_END_DECLS
+
+#endif /* __UBER_HISTOGRAM_H__ */
@@ -0,0 +1,157 @@
+/* uber-layout-cache.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <pango/pangocairo.h>
+
+#include "uber-layout-cache.h"
+
+/**
+ * SECTION:uber-layout-cache
+ * @title: UberLayoutCache
+ * @short_description: Shared layouts for label text.
+ *
+ * Axis labels are drawn from a small set of strings in one font.  The
+ * layout cache keeps a #PangoLayout for each font and text pair, shared by
+ * every graph, so the text is shaped once and the glyphs are reused each
+ * time a background is rendered.
+ *
+ * The layouts belong to a single #PangoContext on the default cairo font
+ * map and must only be used from the main thread.
+ */
+
+#define MAX_LAYOUTS (512)
+
+typedef struct
+{
+	PangoLayout *layout;
+	gint         width;
+	gint         height;
+} Entry;
+
+static PangoContext *context;
+static GHashTable   *fonts;   /* Font string => PangoFontDescription. */
+static GHashTable   *layouts; /* Font and text => Entry. */
+
+/**
+ * uber_layout_cache_entry_free:
+ * @data: An #Entry.
+ *
+ * Frees @data and releases its layout.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_layout_cache_entry_free (gpointer data) /* IN */
+{
+	Entry *entry = data;
+
+	g_object_unref(entry->layout);
+	g_slice_free(Entry, entry);
+}
+
+/**
+ * uber_layout_cache_get_font:
+ * @font: A font description string, such as "Monospace 6".
+ *
+ * Retrieves the parsed font description for @font.
+ *
+ * Returns: A #PangoFontDescription owned by the cache.
+ * Side effects: None.
+ */
+static const PangoFontDescription*
+uber_layout_cache_get_font (const gchar *font) /* IN */
+{
+	PangoFontDescription *desc;
+
+	if (!(desc = g_hash_table_lookup(fonts, font))) {
+		desc = pango_font_description_from_string(font);
+		g_hash_table_insert(fonts, g_strdup(font), desc);
+	}
+	return desc;
+}
+
+/**
+ * uber_layout_cache_lookup:
+ * @font: A font description string, such as "Monospace 6".
+ * @text: The text to lay out.
+ * @width: (out) (allow-none): A location for the width in pixels.
+ * @height: (out) (allow-none): A location for the height in pixels.
+ *
+ * Retrieves a layout of @text in @font, creating and shaping it on first
+ * use.  The layout may be drawn with pango_cairo_show_layout() onto any
+ * cairo context but must not be modified.
+ *
+ * Label text changes with the range of a graph, so the cache is emptied
+ * once it holds too many layouts.  The layout is therefore only valid
+ * until the next lookup.
+ *
+ * Returns: A #PangoLayout owned by the cache.
+ * Side effects: None.
+ */
+PangoLayout*
+uber_layout_cache_lookup (const gchar *font,   /* IN */
+                          const gchar *text,   /* IN */
+                          gint        *width,  /* OUT */
+                          gint        *height) /* OUT */
+{
+	Entry *entry;
+	gchar *key;
+
+	g_return_val_if_fail(font != NULL, NULL);
+	g_return_val_if_fail(text != NULL, NULL);
+
+	if (G_UNLIKELY(!context)) {
+		context = pango_font_map_create_context(
+			pango_cairo_font_map_get_default());
+		fonts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		                              (GDestroyNotify)pango_font_description_free);
+		layouts = g_hash_table_new_full(g_str_hash, g_str_equal, g_free,
+		                                uber_layout_cache_entry_free);
+	}
+	/*
+	 * Font strings never contain a newline, so it separates the two parts
+	 * of the key.
+	 */
+	key = g_strconcat(font, "\n", text, NULL);
+	if (!(entry = g_hash_table_lookup(layouts, key))) {
+		if (g_hash_table_size(layouts) >= MAX_LAYOUTS) {
+			g_hash_table_remove_all(layouts);
+		}
+		entry = g_slice_new0(Entry);
+		entry->layout = pango_layout_new(context);
+		pango_layout_set_font_description(entry->layout,
+		                                  uber_layout_cache_get_font(font));
+		pango_layout_set_text(entry->layout, text, -1);
+		/*
+		 * Measuring shapes the text, so drawing reuses the glyphs.
+		 */
+		pango_layout_get_pixel_size(entry->layout, &entry->width,
+		                            &entry->height);
+		g_hash_table_insert(layouts, key, entry);
+	} else {
+		g_free(key);
+	}
+	if (width) {
+		*width = entry->width;
+	}
+	if (height) {
+		*height = entry->height;
+	}
+	return entry->layout;
+}
@@ -0,0 +1,33 @@
+/* uber-layout-cache.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_LAYOUT_CACHE_H__
+#define __UBER_LAYOUT_CACHE_H__
+
+#include <pango/pango.h>
+
+G_BEGIN_DECLS
+
+PangoLayout* uber_layout_cache_lookup (const gchar *font,
+                                       const gchar *text,
+                                       gint        *width,
+                                       gint        *height);
+
+G_END_DECLS
+
+#endif /* __UBER_LAYOUT_CACHE_H__ */
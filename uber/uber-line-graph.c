@@ -25,12 +25,19 @@
 
 #include "uber-line-graph.h"
 #include "uber-range.h"
+#include "uber-extrema.h"
+#include "uber-rollup.h"
 #include "uber-scale.h"
-#include "g-ring.h"
+#include "uber-series-ring.h"
+#include "uber-spsc-queue.h"
 
 #define RECT_BOTTOM(r) ((r).y + (r).height)
 #define RECT_RIGHT(r)  ((r).x + (r).width)
 #define SCALE_FACTOR   (0.2)
+#define QUEUE_SIZE     (4096)
+#define DRAIN_SIZE     (64)
+#define CURVE_SPACING  (2.0)
+#define SCALE_CHUNK    (16)
 
 /**
  * SECTION:uber-line-graph.h
@@ -44,7 +51,6 @@ G_DEFINE_TYPE(UberLineGraph, uber_line_graph, UBER_TYPE_GRAPH)
 
 typedef struct
 {
-	GRing     *raw_data;
 	GdkRGBA    color;
 	gdouble    width;
 	gdouble   *dashes;
@@ -52,21 +58,42 @@ typedef struct
 	gdouble    dash_offset;
 	UberLabel *label;
 	guint      label_id;
+	UberExtrema extrema;  /* Sliding min and max of the line. */
 } LineInfo;
 
+typedef struct
+{
+	gint64  time;
+	guint   line;
+	gdouble value;
+} Sample;
+
 struct _UberLineGraphPrivate
 {
 	GArray            *lines;
+	UberSeriesRing    *raw_data;   /* Samples for every line. */
+	UberRollup        *rollup;     /* Summaries of older samples. */
+	gint               tier;       /* Rollup tier rendered, or -1 for raw. */
+	UberExtrema        extrema;    /* Sliding min and max of every line. */
+	gdouble           *row;        /* Scratch row for the next samples. */
+	gdouble           *scaled;     /* Scratch for one series once scaled. */
 	cairo_antialias_t  antialias;
 	guint              stride;
 	gboolean           autoscale;
 	UberRange          range;
 	UberScale          scale;
+	UberScaleBatch     scale_batch; /* Span version of scale, or NULL. */
 	gpointer           scale_data;
 	GDestroyNotify     scale_notify;
 	UberLineGraphFunc  func;
 	gpointer           func_data;
 	GDestroyNotify     func_notify;
+	UberLineGraphRowFunc row_func;
+	gpointer           row_func_data;
+	GDestroyNotify     row_func_notify;
+	UberSpscQueue     *queue;      /* Samples pushed from a producer. */
+	gint64             last_time;  /* Time of the previous data tick. */
+	gdouble            curve_spacing; /* Closest points drawn as curves. */
 };
 
 enum
@@ -76,28 +103,6 @@ enum
 	PROP_RANGE,
 };
 
-/**
- * uber_line_graph_init_ring:
- * @ring: A #GRing.
- *
- * Initialize the #GRing to default values (UBER_LINE_GRAPH_NO_VALUE).
- *
- * Returns: None.
- * Side effects: None.
- */
-static inline void
-uber_line_graph_init_ring (GRing *ring) /* IN */
-{
-	gdouble val = UBER_LINE_GRAPH_NO_VALUE;
-	gint i;
-
-	g_return_if_fail(ring != NULL);
-
-	for (i = 0; i < ring->len; i++) {
-		g_ring_append_val(ring, val);
-	}
-}
-
 /**
  * uber_line_graph_new:
  *
@@ -244,10 +249,13 @@ uber_line_graph_add_line (UberLineGraph  *graph, /* IN */
 		gdk_rgba_parse(&info.color, "#729fcf");
 	}
 	/*
-	 * Allocate buffers for data points.
+	 * Allocate buffers for data points.  The series index always matches
+	 * the index of the line within priv->lines.
 	 */
-	info.raw_data = g_ring_sized_new(sizeof(gdouble), priv->stride, NULL);
-	uber_line_graph_init_ring(info.raw_data);
+	uber_series_ring_add_series(priv->raw_data);
+	uber_rollup_add_series(priv->rollup);
+	priv->row = g_renew(gdouble, priv->row, priv->raw_data->n_series);
+	uber_extrema_init(&info.extrema);
 	/*
 	 * Store the newly crated line.
 	 */
@@ -309,52 +317,361 @@ uber_line_graph_get_antialias (UberLineGraph *graph) /* IN */
 	return graph->priv->antialias;
 }
 
+/**
+ * uber_line_graph_set_curve_spacing:
+ * @graph: A #UberLineGraph.
+ * @spacing: The spacing in pixels.
+ *
+ * Sets how far apart, in pixels, consecutive points must be to be joined
+ * with a curve.  Closer points are joined with straight lines, which are
+ * much cheaper to draw and look the same at that size.  A spacing of 0
+ * always uses curves.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_line_graph_set_curve_spacing (UberLineGraph *graph,   /* IN */
+                                   gdouble        spacing) /* IN */
+{
+	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
+	g_return_if_fail(spacing >= 0.);
+
+	graph->priv->curve_spacing = spacing;
+	uber_graph_redraw(UBER_GRAPH(graph));
+}
+
+/**
+ * uber_line_graph_get_curve_spacing:
+ * @graph: A #UberLineGraph.
+ *
+ * Retrieves the spacing set with uber_line_graph_set_curve_spacing().
+ *
+ * Returns: The spacing in pixels.
+ * Side effects: None.
+ */
+gdouble
+uber_line_graph_get_curve_spacing (UberLineGraph *graph) /* IN */
+{
+	g_return_val_if_fail(UBER_IS_LINE_GRAPH(graph), 0.);
+	return graph->priv->curve_spacing;
+}
+
+/**
+ * uber_line_graph_clear_row:
+ * @graph: A #UberLineGraph.
+ *
+ * Resets the scratch row so that every line has no value.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_line_graph_clear_row (UberLineGraph *graph) /* IN */
+{
+	UberLineGraphPrivate *priv;
+	gint i;
+
+	priv = graph->priv;
+	for (i = 0; i < priv->lines->len; i++) {
+		priv->row[i] = UBER_LINE_GRAPH_NO_VALUE;
+	}
+}
+
+/**
+ * uber_line_graph_append_row:
+ * @graph: A #UberLineGraph.
+ * @time: The time of the scratch row.
+ * @scale_changed: (out): Set if the range was grown to fit the row.
+ * @late: (out): Set if the row belongs to an area that was already drawn.
+ *
+ * Stores the scratch row in the sample ring and the sliding extrema,
+ * growing the range to fit them if autoscaling is enabled.
+ *
+ * Returns: %TRUE if any line has a value in the row.
+ * Side effects: None.
+ */
+static gboolean
+uber_line_graph_append_row (UberLineGraph *graph,         /* IN */
+                            gint64         time,          /* IN */
+                            gboolean      *scale_changed, /* OUT */
+                            gboolean      *late)          /* OUT */
+{
+	UberLineGraphPrivate *priv;
+	LineInfo *info;
+	gboolean have_value = FALSE;
+	gdouble min;
+	gdouble max;
+	gint i;
+
+	priv = graph->priv;
+	for (i = 0; i < priv->lines->len; i++) {
+		info = &g_array_index(priv->lines, LineInfo, i);
+		uber_extrema_push(&info->extrema, time, priv->row[i]);
+		uber_extrema_push(&priv->extrema, time, priv->row[i]);
+		if (!isnan(priv->row[i])) {
+			have_value = TRUE;
+		}
+	}
+	/*
+	 * Grow the range away from zero by the scale factor so that negative
+	 * values get headroom below just as positive values do above.
+	 */
+	if (priv->autoscale &&
+	    uber_extrema_get(&priv->extrema, &min, &max)) {
+		if (min < priv->range.begin) {
+			priv->range.begin = min - (fabs(min) * SCALE_FACTOR);
+			priv->range.range = priv->range.end - priv->range.begin;
+			*scale_changed = TRUE;
+		}
+		if (max > priv->range.end) {
+			priv->range.end = max + (fabs(max) * SCALE_FACTOR);
+			priv->range.range = priv->range.end - priv->range.begin;
+			*scale_changed = TRUE;
+		}
+	}
+	if (uber_series_ring_append_row(priv->raw_data, time, priv->row) >= 0 &&
+	    time <= priv->last_time) {
+		*late = TRUE;
+	}
+	uber_rollup_append_row(priv->rollup, time, priv->row);
+	return have_value;
+}
+
+/**
+ * uber_line_graph_get_window:
+ * @graph: A #UberLineGraph.
+ *
+ * Retrieves the span of time covered by the graph.
+ *
+ * Returns: The span in microseconds.
+ * Side effects: None.
+ */
+static inline gint64
+uber_line_graph_get_window (UberLineGraph *graph) /* IN */
+{
+	gfloat dps;
+
+	dps = uber_graph_get_dps(UBER_GRAPH(graph));
+	if (dps <= 0.) {
+		return 0;
+	}
+	return graph->priv->stride * (G_USEC_PER_SEC / dps);
+}
+
+/**
+ * uber_line_graph_expire_extrema:
+ * @graph: A #UberLineGraph.
+ * @time: The time at the right edge of the graph.
+ *
+ * Drops samples that have scrolled off the left edge of the graph from the
+ * sliding extrema.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_line_graph_expire_extrema (UberLineGraph *graph, /* IN */
+                                gint64         time)  /* IN */
+{
+	UberLineGraphPrivate *priv;
+	LineInfo *info;
+	gint64 window;
+	gint i;
+
+	priv = graph->priv;
+	if (!(window = uber_line_graph_get_window(graph))) {
+		return;
+	}
+	for (i = 0; i < priv->lines->len; i++) {
+		info = &g_array_index(priv->lines, LineInfo, i);
+		uber_extrema_expire(&info->extrema, time - window);
+	}
+	uber_extrema_expire(&priv->extrema, time - window);
+}
+
+/**
+ * uber_line_graph_pick_tier:
+ * @graph: A #UberLineGraph.
+ *
+ * Determines where samples should be rendered from.  Raw samples are used
+ * while they cover the whole window with no more than one sample per
+ * pixel column.  Otherwise, the finest rollup tier with buckets at least a
+ * pixel column wide that covers the window is used, so rendering stays
+ * proportional to the width of the graph rather than the number of
+ * samples.
+ *
+ * Returns: The tier index, or -1 for raw samples.
+ * Side effects: None.
+ */
+static gint
+uber_line_graph_pick_tier (UberLineGraph *graph) /* IN */
+{
+	UberLineGraphPrivate *priv;
+	UberRollupTier *tier;
+	GdkRectangle area;
+	gint64 window;
+	gint64 left;
+	gint64 time;
+	gint64 oldest;
+	gdouble usec_per_px;
+	gint fallback = -1;
+	guint n_rows;
+	gint i;
+
+	priv = graph->priv;
+	uber_graph_get_content_area(UBER_GRAPH(graph), &area);
+	window = uber_line_graph_get_window(graph);
+	left = uber_graph_get_data_time(UBER_GRAPH(graph)) - window;
+	usec_per_px = window / (gdouble)MAX(area.width, 1);
+	/*
+	 * Count the raw rows within the window.  If the walk ends inside the
+	 * ring, the raw rows reach back past the left edge.
+	 */
+	for (n_rows = 0; n_rows < priv->raw_data->len; n_rows++) {
+		time = uber_series_ring_get_time(priv->raw_data, n_rows);
+		if (time == G_MININT64 || time < left) {
+			break;
+		}
+	}
+	if (n_rows < priv->raw_data->len && n_rows <= MAX(area.width, 1)) {
+		return -1;
+	}
+	for (i = 0; i < UBER_ROLLUP_N_TIERS; i++) {
+		tier = &priv->rollup->tiers[i];
+		if (!tier->len) {
+			continue;
+		}
+		oldest = uber_rollup_tier_get_start(tier, tier->len - 1);
+		if (oldest != G_MININT64 && oldest > left) {
+			continue;
+		}
+		if (tier->width >= usec_per_px) {
+			return i;
+		}
+		if (fallback < 0) {
+			fallback = i;
+		}
+	}
+	return fallback;
+}
+
+
 /**
  * uber_line_graph_get_next_data:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Collects the samples for the current data tick.  Pushed samples become
+ * rows at their own times, with samples sharing a time forming one row.
+ * Values from a data func become a row at the time of the tick.
  *
- * Returns: None.
+ * Returns: %TRUE if any line received a value.
  * Side effects: None.
  */
 static gboolean
 uber_line_graph_get_next_data (UberGraph *graph) /* IN */
 {
 	UberLineGraphPrivate *priv;
+	UberSpscQueue *queue;
+	Sample samples[DRAIN_SIZE];
+	UberRange clamp;
 	gboolean scale_changed = FALSE;
+	gboolean late = FALSE;
+	gboolean have_row = FALSE;
 	gboolean ret = FALSE;
-	LineInfo *line;
-	gdouble val;
+	gint64 data_time;
+	gint64 row_time = 0;
+	guint n_samples;
+	guint j;
 	gint i;
 
 	g_return_val_if_fail(UBER_IS_LINE_GRAPH(graph), FALSE);
 
 	priv = UBER_LINE_GRAPH(graph)->priv;
+	data_time = uber_graph_get_data_time(graph);
+	queue = g_atomic_pointer_get(&priv->queue);
+	if (!priv->row_func && !priv->func && !queue) {
+		goto finish;
+	}
 	/*
-	 * Retrieve the next data point.
+	 * Drain everything pushed since the last tick in one batch.  Samples
+	 * pushed together with the same time are gathered into a single row.
 	 */
-	if (priv->func) {
-		for (i = 0; i < priv->lines->len; i++) {
-			line = &g_array_index(priv->lines, LineInfo, i);
-			val = priv->func(UBER_LINE_GRAPH(graph), i + 1, priv->func_data);
-			g_ring_append_val(line->raw_data, val);
-			if (priv->autoscale) {
-				if (val < priv->range.begin) {
-					priv->range.begin = val - (val * SCALE_FACTOR);
-					priv->range.range = priv->range.end - priv->range.begin;
-					scale_changed = TRUE;
-				} else if (val > priv->range.end) {
-					priv->range.end = val + (val * SCALE_FACTOR);
-					priv->range.range = priv->range.end - priv->range.begin;
-					scale_changed = TRUE;
+	if (queue) {
+		while ((n_samples = uber_spsc_queue_pop(queue, samples, DRAIN_SIZE))) {
+			for (j = 0; j < n_samples; j++) {
+				if (have_row && samples[j].time != row_time) {
+					ret |= uber_line_graph_append_row(UBER_LINE_GRAPH(graph),
+					                                  row_time, &scale_changed,
+					                                  &late);
+					have_row = FALSE;
+				}
+				if (!have_row) {
+					uber_line_graph_clear_row(UBER_LINE_GRAPH(graph));
+					row_time = samples[j].time;
+					have_row = TRUE;
+				}
+				if (samples[j].line > 0 &&
+				    samples[j].line <= priv->lines->len) {
+					priv->row[samples[j].line - 1] = samples[j].value;
 				}
 			}
 		}
+		if (have_row) {
+			ret |= uber_line_graph_append_row(UBER_LINE_GRAPH(graph), row_time,
+			                                  &scale_changed, &late);
+		}
+	}
+	/*
+	 * Retrieve the next data point for every line as of this tick.  A row
+	 * func fills the whole row in one call.
+	 */
+	if (priv->row_func) {
+		uber_line_graph_clear_row(UBER_LINE_GRAPH(graph));
+		priv->row_func(UBER_LINE_GRAPH(graph), priv->row, priv->lines->len,
+		               priv->row_func_data);
+	} else if (priv->func) {
+		for (i = 0; i < priv->lines->len; i++) {
+			priv->row[i] = priv->func(UBER_LINE_GRAPH(graph), i + 1,
+			                          priv->func_data);
+		}
+	}
+	if (priv->row_func || priv->func) {
+		ret |= uber_line_graph_append_row(UBER_LINE_GRAPH(graph), data_time,
+		                                  &scale_changed, &late);
+	}
+	uber_line_graph_expire_extrema(UBER_LINE_GRAPH(graph), data_time);
+	/*
+	 * A percentile scale follows the samples currently held.
+	 */
+	if (priv->scale == uber_scale_percentile) {
+		clamp = *uber_scale_percentile_get_range(priv->scale_data,
+		                                         &priv->range);
+		uber_scale_percentile_update(priv->scale_data, priv->raw_data->data,
+		                             priv->raw_data->n_series *
+		                             priv->raw_data->len);
+		if (memcmp(&clamp,
+		           uber_scale_percentile_get_range(priv->scale_data,
+		                                           &priv->range),
+		           sizeof(clamp)) != 0) {
+			scale_changed = TRUE;
+		}
 	}
-	if (scale_changed) {
+	/*
+	 * Samples older than the previous tick land in slots that have already
+	 * been rendered, so everything must be drawn again.  The same is true
+	 * when the history is now better drawn from another rollup tier.
+	 */
+	if (uber_line_graph_pick_tier(UBER_LINE_GRAPH(graph)) != priv->tier) {
+		late = TRUE;
+	}
+	if (late) {
+		uber_graph_redraw(graph);
+	} else if (scale_changed) {
 		uber_graph_scale_changed(graph);
 	}
+  finish:
+	priv->last_time = data_time;
 	return ret;
 }
 
@@ -392,6 +709,149 @@ uber_line_graph_set_data_func (UberLineGraph     *graph,     /* IN */
 	priv->func_notify = notify;
 }
 
+/**
+ * uber_line_graph_set_row_func:
+ * @graph: A #UberLineGraph.
+ * @func: A #UberLineGraphRowFunc or %NULL.
+ * @user_data: User data for @func.
+ * @notify: A #GDestroyNotify to free @user_data, or %NULL.
+ *
+ * Sets a callback used to retrieve the next value of every line in a single
+ * call.  When set, it is used in place of the func set with
+ * uber_line_graph_set_data_func().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_line_graph_set_row_func (UberLineGraph        *graph,     /* IN */
+                              UberLineGraphRowFunc  func,      /* IN */
+                              gpointer              user_data, /* IN */
+                              GDestroyNotify        notify)    /* IN */
+{
+	UberLineGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
+
+	priv = graph->priv;
+	/*
+	 * Free existing row func if neccessary.
+	 */
+	if (priv->row_func_notify) {
+		priv->row_func_notify(priv->row_func_data);
+	}
+	/*
+	 * Store row func.
+	 */
+	priv->row_func = func;
+	priv->row_func_data = user_data;
+	priv->row_func_notify = notify;
+}
+
+/**
+ * uber_line_graph_get_queue:
+ * @graph: A #UberLineGraph.
+ *
+ * Retrieves the queue used to push samples to @graph, creating it if
+ * needed.  This is only called from the producer thread, which is the
+ * only thread that creates the queue.
+ *
+ * Returns: An #UberSpscQueue.
+ * Side effects: The queue is created on first use.
+ */
+static UberSpscQueue*
+uber_line_graph_get_queue (UberLineGraph *graph) /* IN */
+{
+	UberLineGraphPrivate *priv;
+	UberSpscQueue *queue;
+
+	priv = graph->priv;
+	if (!(queue = g_atomic_pointer_get(&priv->queue))) {
+		queue = uber_spsc_queue_new(sizeof(Sample), QUEUE_SIZE);
+		g_atomic_pointer_set(&priv->queue, queue);
+	}
+	return queue;
+}
+
+/**
+ * uber_line_graph_push:
+ * @graph: A #UberLineGraph.
+ * @time: The time of the sample in microseconds, such as from
+ *   g_get_monotonic_time().
+ * @line: The line identifier returned from uber_line_graph_add_line().
+ * @value: The value of the sample.
+ *
+ * Pushes a sample for @line.  Pushed samples are collected by the main
+ * loop on the next data tick.  Unlike the data funcs, this may be called
+ * from any one thread at a time, without locking; only a single thread
+ * may push to a given graph.
+ *
+ * Returns: %TRUE if the sample was queued; %FALSE if the queue is full
+ *   and the sample was dropped.
+ * Side effects: None.
+ */
+gboolean
+uber_line_graph_push (UberLineGraph *graph, /* IN */
+                      gint64         time,  /* IN */
+                      guint          line,  /* IN */
+                      gdouble        value) /* IN */
+{
+	Sample sample;
+
+	g_return_val_if_fail(UBER_IS_LINE_GRAPH(graph), FALSE);
+	g_return_val_if_fail(line > 0, FALSE);
+
+	sample.time = time;
+	sample.line = line;
+	sample.value = value;
+	return uber_spsc_queue_push(uber_line_graph_get_queue(graph), &sample, 1);
+}
+
+/**
+ * uber_line_graph_push_row:
+ * @graph: A #UberLineGraph.
+ * @time: The time of the samples in microseconds.
+ * @values: An array of values.
+ * @n_values: The number of elements in @values.
+ *
+ * Pushes a sample for each of the first @n_values lines, where @values[i]
+ * is the value for line i + 1.  Either the whole row is queued or none of
+ * it is.  See uber_line_graph_push() for threading rules.
+ *
+ * Returns: %TRUE if the row was queued; %FALSE if the queue is full and
+ *   the row was dropped.
+ * Side effects: None.
+ */
+gboolean
+uber_line_graph_push_row (UberLineGraph *graph,    /* IN */
+                          gint64         time,     /* IN */
+                          const gdouble *values,   /* IN */
+                          guint          n_values) /* IN */
+{
+	Sample samples[DRAIN_SIZE];
+	Sample *row = samples;
+	gboolean ret;
+	guint i;
+
+	g_return_val_if_fail(UBER_IS_LINE_GRAPH(graph), FALSE);
+	g_return_val_if_fail(values != NULL || n_values == 0, FALSE);
+
+	if (n_values > G_N_ELEMENTS(samples)) {
+		row = g_new(Sample, n_values);
+	}
+	for (i = 0; i < n_values; i++) {
+		row[i].time = time;
+		row[i].line = i + 1;
+		row[i].value = values[i];
+	}
+	ret = uber_spsc_queue_push(uber_line_graph_get_queue(graph), row,
+	                           n_values);
+	if (row != samples) {
+		g_free(row);
+	}
+	return ret;
+}
+
 /**
  * uber_line_graph_stylize_line:
  * @graph: A #UberLineGraph.
@@ -428,43 +888,203 @@ uber_line_graph_stylize_line (UberLineGraph *graph, /* IN */
                           info->color.alpha);
 }
 
+/*
+ * A point within a pixel column.  @order is the position of the point in
+ * the walk, so points can be emitted in the order they were visited.
+ */
+typedef struct
+{
+	guint   order;
+	gdouble x;
+	gdouble y;
+} ColumnPoint;
+
+/*
+ * The state of a path as decimated points are added to it.
+ */
+typedef struct
+{
+	gdouble  spacing;
+	gboolean first;
+	gdouble  last_x;
+	gdouble  last_y;
+} PathState;
+
 /**
- * uber_line_graph_render:
- * @graph: A #UberGraph.
+ * uber_line_graph_path_add:
  * @cr: A #cairo_t context.
- * @area: Full area to render contents within.
+ * @path: A #PathState.
+ * @x: The x coordinate.
+ * @y: The y coordinate.
+ *
+ * Adds a point to the current path.  Points far enough apart are joined
+ * with a curve using the last point as control; closer points are joined
+ * with a straight line.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_line_graph_path_add (cairo_t   *cr,   /* IN */
+                          PathState *path, /* IN */
+                          gdouble    x,    /* IN */
+                          gdouble    y)    /* IN */
+{
+	if (path->first) {
+		cairo_move_to(cr, x, y);
+		path->first = FALSE;
+	} else if (path->last_x - x < path->spacing) {
+		cairo_line_to(cr, x, y);
+	} else {
+		cairo_curve_to(cr,
+		               (path->last_x + x) / 2.,
+		               path->last_y,
+		               (path->last_x + x) / 2.,
+		               y, x, y);
+	}
+	path->last_x = x;
+	path->last_y = y;
+}
+
+/**
+ * uber_line_graph_flush_column:
+ * @cr: A #cairo_t context.
+ * @path: A #PathState.
+ * @points: The newest, oldest, lowest and highest points of a column.
+ *
+ * Adds the distinct points of a pixel column to the path in the order they
+ * were visited.  This keeps the shape of the column, including its
+ * extremes, with at most four points however many samples it held.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_line_graph_flush_column (cairo_t     *cr,        /* IN */
+                              PathState   *path,      /* IN */
+                              ColumnPoint  points[4]) /* IN */
+{
+	ColumnPoint tmp;
+	gint i;
+	gint j;
+
+	/*
+	 * Sort the four points by visit order.
+	 */
+	for (i = 1; i < 4; i++) {
+		for (j = i; j > 0 && points[j - 1].order > points[j].order; j--) {
+			tmp = points[j];
+			points[j] = points[j - 1];
+			points[j - 1] = tmp;
+		}
+	}
+	for (i = 0; i < 4; i++) {
+		if (i == 0 || points[i].order != points[i - 1].order) {
+			uber_line_graph_path_add(cr, path, points[i].x, points[i].y);
+		}
+	}
+}
+
+/**
+ * uber_line_graph_scale_values:
+ * @graph: A #UberLineGraph.
+ * @pixel_range: The pixel range to translate into.
+ * @values: The values to translate.
+ * @pixels: (out): A location for @n_values translated values.
+ * @n_values: The number of values.
+ *
+ * Translates a span of values with the scale of the graph in one call.
+ * Values without a value, or which the scale cannot translate, are %NAN
+ * afterwards.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_line_graph_scale_values (UberLineGraph   *graph,       /* IN */
+                              const UberRange *pixel_range, /* IN */
+                              const gdouble   *values,      /* IN */
+                              gdouble         *pixels,      /* OUT */
+                              guint            n_values)    /* IN */
+{
+	UberLineGraphPrivate *priv;
+
+	priv = graph->priv;
+	if (priv->scale_batch) {
+		priv->scale_batch(&priv->range, pixel_range, values, pixels,
+		                  n_values, priv->scale_data);
+	} else {
+		uber_scale_apply(priv->scale, &priv->range, pixel_range, values,
+		                 pixels, n_values, priv->scale_data);
+	}
+}
+
+/**
+ * uber_line_graph_render_line:
+ * @graph: A #UberLineGraph.
+ * @cr: A #cairo_t context.
+ * @area: The area to render within.
  * @line: The line to render.
+ * @series: The index of @line.
+ * @epoch: The x position of the most recent data tick.
+ * @each: The number of pixels between data ticks.
+ *
+ * Renders the samples of a particular line that fall within @area.  Each
+ * sample is placed by its time relative to the most recent data tick, so
+ * samples that arrive in bursts or at irregular rates keep their real
+ * spacing.  Samples with no value are skipped and the line continues
+ * through them.
  *
- * Render a particular line to the graph.
+ * Samples are decimated per pixel column before the path is built; only
+ * the first, last, lowest and highest sample of each column is drawn.
  *
  * Returns: None.
  * Side effects: None.
  */
 static void
-uber_line_graph_render_line (UberLineGraph *graph, /* IN */
-                             cairo_t       *cr,    /* IN */
-                             GdkRectangle  *area,  /* IN */
-                             LineInfo      *line,  /* IN */
-                             guint          epoch, /* IN */
-                             gfloat         each)  /* IN */
+uber_line_graph_render_line (UberLineGraph *graph,  /* IN */
+                             cairo_t       *cr,     /* IN */
+                             GdkRectangle  *area,   /* IN */
+                             LineInfo      *line,   /* IN */
+                             guint          series, /* IN */
+                             guint          epoch,  /* IN */
+                             gfloat         each)   /* IN */
 {
 	UberLineGraphPrivate *priv;
 	UberRange pixel_range;
-	GdkRectangle vis;
-	guint x;
-	guint last_x;
+	GRingSpan spans[2];
+	GRingSpan time_spans[2];
+	ColumnPoint points[4];
+	PathState path;
+	gdouble *values;
+	gint64 *times;
+	gint64 data_time;
+	gdouble px_per_usec;
+	gdouble x;
 	gdouble y;
-	gdouble last_y;
 	gdouble val;
-	gint i;
+	gboolean have_column = FALSE;
+	gint column = 0;
+	guint order = 0;
+	gint n_spans;
+	gint scaled_from;
+	gint chunk;
+	gint j;
+	gint s;
 
 	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
 
 	priv = graph->priv;
-	uber_graph_get_content_area(UBER_GRAPH(graph), &vis);
 	pixel_range.begin = area->y + 1;
 	pixel_range.end = area->y + area->height;
 	pixel_range.range = pixel_range.end - pixel_range.begin;
+	data_time = uber_graph_get_data_time(UBER_GRAPH(graph));
+	px_per_usec = each * uber_graph_get_dps(UBER_GRAPH(graph))
+	            / (gdouble)G_USEC_PER_SEC;
+	path.spacing = priv->curve_spacing;
+	path.first = TRUE;
+	path.last_x = 0.;
+	path.last_y = 0.;
 	/*
 	 * Prepare cairo settings.
 	 */
@@ -474,51 +1094,91 @@ uber_line_graph_render_line (UberLineGraph *graph, /* IN */
 	 */
 	cairo_new_path(cr);
 	/*
-	 * Draw the line contents as bezier curves.
+	 * Walk the spans from the most recent value backwards until a point at
+	 * or past the left edge of @area has been added.
 	 */
-	for (i = 0; i < line->raw_data->len; i++) {
-		/*
-		 * Retrieve data point.
-		 */
-		val = g_ring_get_index(line->raw_data, gdouble, i);
-		/*
-		 * Once we get to UBER_LINE_GRAPH_NO_VALUE, we must be at the end of the data
-		 * sequence.  This may not always be true in the future.
-		 */
-		if (val == UBER_LINE_GRAPH_NO_VALUE) {
-			break;
-		}
-		/*
-		 * Translate value to coordinate system.
-		 */
-		if (!priv->scale(&priv->range, &pixel_range, &val, priv->scale_data)) {
-			break;
-		}
-		/*
-		 * Calculate X/Y coordinate.
-		 */
-		y = (gint)(RECT_BOTTOM(*area) - val) - .5;
-		x = epoch - (each * i);
-		if (i == 0) {
+	n_spans = uber_series_ring_get_spans(priv->raw_data, series, spans);
+	uber_series_ring_get_time_spans(priv->raw_data, time_spans);
+	values = priv->scaled;
+	chunk = SCALE_CHUNK;
+	for (s = n_spans - 1; s >= 0; s--) {
+		times = time_spans[s].data;
+		scaled_from = spans[s].len;
+		for (j = spans[s].len - 1; j >= 0; j--) {
 			/*
-			 * Just move to the right position on first entry.
+			 * Rows that were never written are the oldest, so there is
+			 * nothing left to draw.
 			 */
-			cairo_move_to(cr, x, y);
-			goto next;
-		} else {
+			if (times[j] == G_MININT64) {
+				goto finish;
+			}
 			/*
-			 * Draw curve to data point using the last X/Y positions as
-			 * control points.
+			 * Translate rows to the coordinate system a chunk at a time
+			 * rather than calling the scale once per sample.  The walk
+			 * usually stops well before the start of the span, as when
+			 * only the newest slot is drawn, so only the rows it reaches
+			 * are scaled.  Chunks double in size to keep the number of
+			 * calls small for full renders.
 			 */
-			cairo_curve_to(cr,
-			               last_x - (each / 2.),
-			               last_y,
-			               last_x - (each / 2.),
-			               y, x, y);
+			if (j < scaled_from) {
+				scaled_from = MAX(0, j + 1 - chunk);
+				uber_line_graph_scale_values(graph, &pixel_range,
+				                             (gdouble *)spans[s].data +
+				                             scaled_from,
+				                             values + scaled_from,
+				                             j + 1 - scaled_from);
+				chunk *= 2;
+			}
+			/*
+			 * Skip rows where this line has no value.
+			 */
+			val = values[j];
+			if (isnan(val)) {
+				continue;
+			}
+			/*
+			 * Calculate X/Y coordinate.
+			 */
+			y = (gint)(RECT_BOTTOM(*area) - val) - .5;
+			x = epoch - ((data_time - times[j]) * px_per_usec);
+			/*
+			 * Flush the previous column once the walk leaves it.
+			 */
+			if (have_column && (gint)floor(x) != column) {
+				uber_line_graph_flush_column(cr, &path, points);
+				have_column = FALSE;
+			}
+			if (!have_column) {
+				column = (gint)floor(x);
+				points[0].order = order;
+				points[0].x = x;
+				points[0].y = y;
+				points[1] = points[2] = points[3] = points[0];
+				have_column = TRUE;
+			} else {
+				/*
+				 * The walk runs backwards in time, so points[1] is always
+				 * the oldest point seen in the column.
+				 */
+				points[1].order = order;
+				points[1].x = x;
+				points[1].y = y;
+				if (y < points[2].y) {
+					points[2] = points[1];
+				}
+				if (y > points[3].y) {
+					points[3] = points[1];
+				}
+			}
+			order++;
+			if (x <= area->x) {
+				goto finish;
+			}
 		}
-	  next:
-		last_y = y;
-		last_x = x;
+	}
+  finish:
+	if (have_column) {
+		uber_line_graph_flush_column(cr, &path, points);
 	}
 	/*
 	 * Stroke the line content.
@@ -526,6 +1186,128 @@ uber_line_graph_render_line (UberLineGraph *graph, /* IN */
 	cairo_stroke(cr);
 }
 
+/**
+ * uber_line_graph_render_tier:
+ * @graph: A #UberLineGraph.
+ * @cr: A #cairo_t context.
+ * @area: The area to render within.
+ * @line: The line to render.
+ * @series: The index of @line.
+ * @tier: The rollup tier to render from.
+ * @epoch: The x position of the most recent data tick.
+ * @each: The number of pixels between data ticks.
+ *
+ * Renders a particular line from the buckets of a rollup tier.  Each
+ * bucket is drawn at its center as a vertical run through its newest,
+ * largest and smallest values so that peaks survive the rollup.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_line_graph_render_tier (UberLineGraph  *graph,  /* IN */
+                             cairo_t        *cr,     /* IN */
+                             GdkRectangle   *area,   /* IN */
+                             LineInfo       *line,   /* IN */
+                             guint           series, /* IN */
+                             UberRollupTier *tier,   /* IN */
+                             guint           epoch,  /* IN */
+                             gfloat          each)   /* IN */
+{
+	UberLineGraphPrivate *priv;
+	UberRollupBucket *bucket;
+	UberRange pixel_range;
+	gint64 data_time;
+	gint64 start;
+	gdouble px_per_usec;
+	gdouble values[3];
+	gdouble x;
+	gboolean first = TRUE;
+	guint i;
+	gint j;
+
+	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
+
+	priv = graph->priv;
+	pixel_range.begin = area->y + 1;
+	pixel_range.end = area->y + area->height;
+	pixel_range.range = pixel_range.end - pixel_range.begin;
+	data_time = uber_graph_get_data_time(UBER_GRAPH(graph));
+	px_per_usec = each * uber_graph_get_dps(UBER_GRAPH(graph))
+	            / (gdouble)G_USEC_PER_SEC;
+	uber_line_graph_stylize_line(graph, line, cr);
+	cairo_new_path(cr);
+	for (i = 0; i < tier->len; i++) {
+		if ((start = uber_rollup_tier_get_start(tier, i)) == G_MININT64) {
+			break;
+		}
+		bucket = &uber_rollup_tier_get_bucket(tier, series, i);
+		if (!bucket->count) {
+			continue;
+		}
+		/*
+		 * The newest bucket is still filling, so don't let its center run
+		 * past the most recent data tick.
+		 */
+		x = epoch - ((data_time - (start + (tier->width / 2))) * px_per_usec);
+		x = MIN(x, epoch);
+		values[0] = bucket->last;
+		values[1] = bucket->max;
+		values[2] = bucket->min;
+		uber_line_graph_scale_values(graph, &pixel_range, values, values,
+		                             G_N_ELEMENTS(values));
+		for (j = 0; j < G_N_ELEMENTS(values); j++) {
+			if (isnan(values[j])) {
+				continue;
+			}
+			values[j] = (gint)(RECT_BOTTOM(*area) - values[j]) - .5;
+			if (first) {
+				cairo_move_to(cr, x, values[j]);
+				first = FALSE;
+			} else {
+				cairo_line_to(cr, x, values[j]);
+			}
+		}
+		if (x <= area->x) {
+			break;
+		}
+	}
+	cairo_stroke(cr);
+}
+
+/**
+ * uber_line_graph_render_lines:
+ * @graph: A #UberLineGraph.
+ *
+ * Renders every line from the current source of samples.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_line_graph_render_lines (UberLineGraph *graph, /* IN */
+                              cairo_t       *cr,    /* IN */
+                              GdkRectangle  *rect,  /* IN */
+                              guint          epoch, /* IN */
+                              gfloat         each)  /* IN */
+{
+	UberLineGraphPrivate *priv;
+	LineInfo *line;
+	gint i;
+
+	priv = graph->priv;
+	for (i = 0; i < priv->lines->len; i++) {
+		line = &g_array_index(priv->lines, LineInfo, i);
+		if (priv->tier < 0) {
+			uber_line_graph_render_line(graph, cr, rect, line, i, epoch, each);
+		} else {
+			uber_line_graph_render_tier(graph, cr, rect, line, i,
+			                            &priv->rollup->tiers[priv->tier],
+			                            epoch, each);
+		}
+	}
+}
+
 /**
  * uber_line_graph_render:
  * @graph: A #UberGraph.
@@ -543,27 +1325,26 @@ uber_line_graph_render (UberGraph    *graph, /* IN */
                         gfloat        each)  /* IN */
 {
 	UberLineGraphPrivate *priv;
-	LineInfo *line;
-	gint i;
 
 	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
 
 	priv = UBER_LINE_GRAPH(graph)->priv;
 	/*
-	 * Render each line to the graph.
+	 * Pick where to draw from.  Fast renders keep using this choice until
+	 * the next full render so that slots always match their neighbours.
 	 */
-	for (i = 0; i < priv->lines->len; i++) {
-		line = &g_array_index(priv->lines, LineInfo, i);
-		uber_line_graph_render_line(UBER_LINE_GRAPH(graph), cr, rect,
-		                            line, epoch, each);
-	}
+	priv->tier = uber_line_graph_pick_tier(UBER_LINE_GRAPH(graph));
+	uber_line_graph_render_lines(UBER_LINE_GRAPH(graph), cr, rect, epoch,
+	                             each);
 }
 
 /**
  * uber_line_graph_render_fast:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Renders the newest slot of the graph.  Every sample that falls within
+ * the slot is drawn, along with the segment joining it to the sample
+ * before it.
  *
  * Returns: None.
  * Side effects: None.
@@ -575,64 +1356,16 @@ uber_line_graph_render_fast (UberGraph    *graph, /* IN */
                              guint         epoch, /* IN */
                              gfloat        each)  /* IN */
 {
-	UberLineGraphPrivate *priv;
-	UberRange pixel_range;
-	LineInfo *line;
-	gdouble last_y;
-	gdouble y;
-	gint i;
-
 	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
 	g_return_if_fail(cr != NULL);
 	g_return_if_fail(rect != NULL);
 
-	priv = UBER_LINE_GRAPH(graph)->priv;
-	pixel_range.begin = rect->y + 1;
-	pixel_range.end = rect->y + rect->height;
-	pixel_range.range = pixel_range.end - pixel_range.begin;
 	/*
-	 * Render most recent data point for each line.
+	 * Rendering is clipped to the slot, so this is the same walk as a full
+	 * render except that it stops at the left edge of the slot.
 	 */
-	for (i = 0; i < priv->lines->len; i++) {
-		line = &g_array_index(priv->lines, LineInfo, i);
-		uber_line_graph_stylize_line(UBER_LINE_GRAPH(graph), line, cr);
-		/*
-		 * Calculate positions.
-		 */
-		y = g_ring_get_index(line->raw_data, gdouble, 0);
-		last_y = g_ring_get_index(line->raw_data, gdouble, 1);
-		/*
-		 * Don't try to draw before we have real values.
-		 */
-		if ((isnan(y) || isinf(y)) || (isnan(last_y) || isinf(last_y))) {
-			continue;
-		}
-		/*
-		 * Translate to coordinate scale.
-		 */
-		if (!priv->scale(&priv->range, &pixel_range, &y, priv->scale_data) ||
-		    !priv->scale(&priv->range, &pixel_range, &last_y, priv->scale_data)) {
-			continue;
-		}
-		/*
-		 * Translate position from bottom right corner.
-		 */
-		y = (gint)(RECT_BOTTOM(*rect) - y) - .5;
-		last_y = (gint)(RECT_BOTTOM(*rect) - last_y) - .5;
-		/*
-		 * Convert relative position to fixed from bottom pixel.
-		 */
-		cairo_new_path(cr);
-		cairo_move_to(cr, epoch, y);
-		cairo_curve_to(cr,
-		               epoch - (each / 2.),
-		               y,
-		               epoch - (each / 2.),
-		               last_y,
-		               epoch - each,
-		               last_y);
-		cairo_stroke(cr);
-	}
+	uber_line_graph_render_lines(UBER_LINE_GRAPH(graph), cr, rect, epoch,
+	                             each);
 }
 
 /**
@@ -650,26 +1383,19 @@ uber_line_graph_set_stride (UberGraph *graph,  /* IN */
                             guint      stride) /* IN */
 {
 	UberLineGraphPrivate *priv;
-	LineInfo *line;
-	gint i;
 
 	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
 
 	priv = UBER_LINE_GRAPH(graph)->priv;
 	priv->stride = stride;
 	/*
-	 * TODO: Support changing stride after lines have been added.
+	 * Resize the existing buffers in place so that the most recent history
+	 * is kept.  Slots added beyond the preserved values have no value.
 	 */
-	if (priv->lines->len) {
-		for (i = 0; i < priv->lines->len; i++) {
-			line = &g_array_index(priv->lines, LineInfo, i);
-			g_ring_unref(line->raw_data);
-			line->raw_data = g_ring_sized_new(sizeof(gdouble),
-			                                  priv->stride, NULL);
-			uber_line_graph_init_ring(line->raw_data);
-		}
-		return;
-	}
+	uber_series_ring_resize(priv->raw_data, priv->stride);
+	priv->scaled = g_renew(gdouble, priv->scaled, priv->stride);
+	uber_rollup_set_window(priv->rollup,
+	                       uber_line_graph_get_window(UBER_LINE_GRAPH(graph)));
 }
 
 /**
@@ -710,6 +1436,83 @@ uber_line_graph_set_range (UberLineGraph   *graph, /* IN */
 	priv->range = *range;
 }
 
+/**
+ * uber_line_graph_get_line_range:
+ * @graph: A #UberLineGraph.
+ * @line: The line identifier returned from uber_line_graph_add_line().
+ * @range: (out): A location for the range.
+ *
+ * Retrieves the smallest and largest values of @line that are currently
+ * within the visible span of time.
+ *
+ * Returns: %TRUE if @line has any visible values; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_line_graph_get_line_range (UberLineGraph *graph, /* IN */
+                                guint          line,  /* IN */
+                                UberRange     *range) /* OUT */
+{
+	LineInfo *info;
+
+	g_return_val_if_fail(UBER_IS_LINE_GRAPH(graph), FALSE);
+	g_return_val_if_fail(line > 0, FALSE);
+	g_return_val_if_fail(line <= graph->priv->lines->len, FALSE);
+	g_return_val_if_fail(range != NULL, FALSE);
+
+	info = &g_array_index(graph->priv->lines, LineInfo, line - 1);
+	if (!uber_extrema_get(&info->extrema, &range->begin, &range->end)) {
+		return FALSE;
+	}
+	range->range = range->end - range->begin;
+	return TRUE;
+}
+
+/**
+ * uber_line_graph_set_scale:
+ * @graph: A #UberLineGraph.
+ * @scale: An #UberScale, or %NULL for uber_scale_linear().
+ * @scale_batch: The #UberScaleBatch equivalent of @scale, or %NULL.
+ * @user_data: user data for @scale and @scale_batch.
+ * @notify: A #GDestroyNotify for @user_data, or %NULL.
+ *
+ * Sets the scale used to place values vertically.  @scale_batch is used to
+ * translate many values at once when it is provided.  The Y axis is
+ * labeled to match @scale.
+ *
+ * When @scale is uber_scale_percentile(), @user_data must be an
+ * #UberScalePercentile; it is updated from the samples on every data tick.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_line_graph_set_scale (UberLineGraph  *graph,       /* IN */
+                           UberScale       scale,       /* IN */
+                           UberScaleBatch  scale_batch, /* IN */
+                           gpointer        user_data,   /* IN */
+                           GDestroyNotify  notify)      /* IN */
+{
+	UberLineGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
+	g_return_if_fail(scale != uber_scale_percentile || user_data != NULL);
+
+	priv = graph->priv;
+	if (priv->scale_notify) {
+		priv->scale_notify(priv->scale_data);
+	}
+	if (!scale) {
+		scale = uber_scale_linear;
+		scale_batch = uber_scale_linear_batch;
+	}
+	priv->scale = scale;
+	priv->scale_batch = scale_batch;
+	priv->scale_data = user_data;
+	priv->scale_notify = notify;
+	uber_graph_redraw(UBER_GRAPH(graph));
+}
+
 /**
  * uber_line_graph_get_yrange:
  * @graph: A #UberGraph.
@@ -730,6 +1533,35 @@ uber_line_graph_get_yrange (UberGraph *graph, /* IN */
 
 	priv = UBER_LINE_GRAPH(graph)->priv;
 	*range = priv->range;
+	if (priv->scale == uber_scale_percentile) {
+		*range = *uber_scale_percentile_get_range(priv->scale_data,
+		                                          &priv->range);
+	}
+}
+
+/**
+ * uber_line_graph_get_yscale:
+ * @graph: A #UberGraph.
+ * @scale: (out): A location for the #UberScale.
+ * @scale_data: (out): A location for the user data of @scale.
+ *
+ * Retrieves the scale used to place values vertically.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_line_graph_get_yscale (UberGraph *graph,      /* IN */
+                            UberScale *scale,      /* OUT */
+                            gpointer  *scale_data) /* OUT */
+{
+	UberLineGraphPrivate *priv;
+
+	g_return_if_fail(UBER_IS_LINE_GRAPH(graph));
+
+	priv = UBER_LINE_GRAPH(graph)->priv;
+	*scale = priv->scale;
+	*scale_data = priv->scale_data;
 }
 
 /**
@@ -812,11 +1644,9 @@ uber_line_graph_downscale (UberGraph *graph) /* IN */
 {
 	UberLineGraphPrivate *priv;
 	gboolean ret = FALSE;
-	gdouble val = 0;
-	gdouble cur;
-	LineInfo *line;
-	gint i;
-	gint j;
+	gdouble min;
+	gdouble max;
+	gdouble val;
 
 	g_return_val_if_fail(UBER_IS_LINE_GRAPH(graph), FALSE);
 
@@ -828,24 +1658,28 @@ uber_line_graph_downscale (UberGraph *graph) /* IN */
 		return FALSE;
 	}
 	/*
-	 * Determine the largest value available.
+	 * The sliding extrema already hold the smallest and largest values
+	 * still on screen.
 	 */
-	for (i = 0; i < priv->lines->len; i++) {
-		line = &g_array_index(priv->lines, LineInfo, i);
-		for (j = 0; j < line->raw_data->len; j++) {
-			cur = g_ring_get_index(line->raw_data, gdouble, j);
-			val = (cur > val) ? cur : val;
-		}
+	if (!uber_extrema_get(&priv->extrema, &min, &max)) {
+		return FALSE;
 	}
 	/*
-	 * Downscale if we can.
+	 * Shrink either end toward the data if we can, but never past zero so
+	 * that the baseline stays in view.
 	 */
-	if (val != priv->range.begin) {
-		if ((val * (1. + SCALE_FACTOR)) < priv->range.end) {
-			priv->range.end = val * (1. + SCALE_FACTOR);
-			priv->range.range = priv->range.end - priv->range.begin;
-			ret = TRUE;
-		}
+	val = MAX(0., max + (fabs(max) * SCALE_FACTOR));
+	if (val < priv->range.end && val > priv->range.begin) {
+		priv->range.end = val;
+		ret = TRUE;
+	}
+	val = MIN(0., min - (fabs(min) * SCALE_FACTOR));
+	if (val > priv->range.begin && val < priv->range.end) {
+		priv->range.begin = val;
+		ret = TRUE;
+	}
+	if (ret) {
+		priv->range.range = priv->range.end - priv->range.begin;
 	}
 	return ret;
 }
@@ -873,9 +1707,27 @@ uber_line_graph_finalize (GObject *object) /* IN */
 	 */
 	for (i = 0; i < priv->lines->len; i++) {
 		line = &g_array_index(priv->lines, LineInfo, i);
-		g_ring_unref(line->raw_data);
 		g_free(line->dashes);
+		uber_extrema_destroy(&line->extrema);
+	}
+	uber_extrema_destroy(&priv->extrema);
+	uber_series_ring_free(priv->raw_data);
+	uber_rollup_free(priv->rollup);
+	g_free(priv->row);
+	g_free(priv->scaled);
+	/*
+	 * Release data funcs.
+	 */
+	if (priv->func_notify) {
+		priv->func_notify(priv->func_data);
+	}
+	if (priv->row_func_notify) {
+		priv->row_func_notify(priv->row_func_data);
+	}
+	if (priv->scale_notify) {
+		priv->scale_notify(priv->scale_data);
 	}
+	uber_spsc_queue_free(priv->queue);
 	G_OBJECT_CLASS(uber_line_graph_parent_class)->finalize(object);
 }
 
@@ -962,6 +1814,7 @@ uber_line_graph_class_init (UberLineGraphClass *klass) /* IN */
 	graph_class->downscale = uber_line_graph_downscale;
 	graph_class->get_next_data = uber_line_graph_get_next_data;
 	graph_class->get_yrange = uber_line_graph_get_yrange;
+	graph_class->get_yscale = uber_line_graph_get_yscale;
 	graph_class->render = uber_line_graph_render;
 	graph_class->render_fast = uber_line_graph_render_fast;
 	graph_class->set_stride = uber_line_graph_set_stride;
@@ -1010,6 +1863,13 @@ uber_line_graph_init (UberLineGraph *graph) /* IN */
 	priv->stride = 60;
 	priv->antialias = CAIRO_ANTIALIAS_DEFAULT;
 	priv->lines = g_array_sized_new(FALSE, FALSE, sizeof(LineInfo), 2);
+	priv->raw_data = uber_series_ring_new(priv->stride);
+	priv->rollup = uber_rollup_new();
+	priv->tier = -1;
+	uber_extrema_init(&priv->extrema);
+	priv->curve_spacing = CURVE_SPACING;
 	priv->scale = uber_scale_linear;
+	priv->scale_batch = uber_scale_linear_batch;
+	priv->scaled = g_new(gdouble, priv->stride);
 	priv->autoscale = TRUE;
 }
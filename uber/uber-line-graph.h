@@ -55,6 +55,25 @@ typedef gdouble (*UberLineGraphFunc)  (UberLineGraph *graph,
                                        guint          line,
                                        gpointer       user_data);
 
+/**
+ * UberLineGraphRowFunc:
+ * @graph: A #UberLineGraph.
+ * @values: An array to store the next value of every line.
+ * @n_values: The number of elements in @values.
+ * @user_data: User data supplied to uber_line_graph_set_row_func().
+ *
+ * Callback prototype for retrieving the next data point of every line in
+ * the graph at once.  @values[i] holds the value for line i + 1 and is
+ * initialized to %UBER_LINE_GRAPH_NO_VALUE before the callback is invoked.
+ *
+ * Returns: None.
+ * Side effects: Implementation dependent.
+ */
+typedef void    (*UberLineGraphRowFunc) (UberLineGraph *graph,
+                                         gdouble       *values,
+                                         guint          n_values,
+                                         gpointer       user_data);
+
 struct _UberLineGraph
 {
 	UberGraph parent;
@@ -80,12 +99,32 @@ void              uber_line_graph_set_data_func  (UberLineGraph     *graph,
                                                   UberLineGraphFunc  func,
                                                   gpointer           user_data,
                                                   GDestroyNotify     notify);
+void              uber_line_graph_set_row_func   (UberLineGraph        *graph,
+                                                  UberLineGraphRowFunc  func,
+                                                  gpointer              user_data,
+                                                  GDestroyNotify        notify);
+gboolean          uber_line_graph_push           (UberLineGraph     *graph,
+                                                  gint64             time,
+                                                  guint              line,
+                                                  gdouble            value);
+gboolean          uber_line_graph_push_row       (UberLineGraph     *graph,
+                                                  gint64             time,
+                                                  const gdouble     *values,
+                                                  guint              n_values);
 gboolean          uber_line_graph_get_autoscale  (UberLineGraph     *graph);
 void              uber_line_graph_set_autoscale  (UberLineGraph     *graph,
                                                   gboolean           autoscale);
 const UberRange*  uber_line_graph_get_range      (UberLineGraph     *graph);
 void              uber_line_graph_set_range      (UberLineGraph     *graph,
                                                   const UberRange   *range);
+gboolean          uber_line_graph_get_line_range (UberLineGraph     *graph,
+                                                  guint              line,
+                                                  UberRange         *range);
+void              uber_line_graph_set_scale      (UberLineGraph     *graph,
+                                                  UberScale          scale,
+                                                  UberScaleBatch     scale_batch,
+                                                  gpointer           user_data,
+                                                  GDestroyNotify     notify);
 void              uber_line_graph_set_line_dash  (UberLineGraph     *graph,
                                                   guint              line,
                                                   const gdouble     *dashes,
@@ -94,6 +133,9 @@ void              uber_line_graph_set_line_dash  (UberLineGraph     *graph,
 void              uber_line_graph_set_line_width (UberLineGraph     *graph,
                                                   gint               line,
                                                   gdouble            width);
+gdouble           uber_line_graph_get_curve_spacing (UberLineGraph *graph);
+void              uber_line_graph_set_curve_spacing (UberLineGraph *graph,
+                                                     gdouble        spacing);
 
 G_END_DECLS
 
@@ -0,0 +1,326 @@
+/* uber-rollup.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "uber-rollup.h"
+
+/*
+ * Tiers larger than this are not kept.  A coarser tier covers the same
+ * window with fewer buckets.
+ */
+#define MAX_BUCKETS (2048)
+
+static const gint64 tier_widths[UBER_ROLLUP_N_TIERS] = {
+	G_USEC_PER_SEC / 10,
+	G_USEC_PER_SEC,
+	G_USEC_PER_SEC * 10,
+	G_USEC_PER_SEC * 60,
+	G_USEC_PER_SEC * 600,
+};
+
+/**
+ * uber_rollup_bucket_reset:
+ * @buckets: An array of #UberRollupBucket.
+ * @n_buckets: The number of elements in @buckets.
+ *
+ * Resets every element of @buckets so that it holds no values.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_rollup_bucket_reset (UberRollupBucket *buckets,   /* IN */
+                          gsize             n_buckets) /* IN */
+{
+	gsize i;
+
+	for (i = 0; i < n_buckets; i++) {
+		buckets[i].min = INFINITY;
+		buckets[i].max = -INFINITY;
+		buckets[i].sum = 0.;
+		buckets[i].last = NAN;
+		buckets[i].count = 0;
+	}
+}
+
+/**
+ * uber_rollup_new:
+ *
+ * Creates a new #UberRollup with no series.  No buckets are kept until a
+ * window is set with uber_rollup_set_window().
+ *
+ * Returns: A new #UberRollup which should be freed with uber_rollup_free().
+ * Side effects: None.
+ */
+UberRollup*
+uber_rollup_new (void)
+{
+	UberRollup *rollup;
+	gint i;
+
+	rollup = g_slice_new0(UberRollup);
+	for (i = 0; i < UBER_ROLLUP_N_TIERS; i++) {
+		rollup->tiers[i].width = tier_widths[i];
+	}
+	return rollup;
+}
+
+/**
+ * uber_rollup_free:
+ * @rollup: An #UberRollup.
+ *
+ * Frees @rollup and all of its buckets.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_rollup_free (UberRollup *rollup) /* IN */
+{
+	gint i;
+
+	if (rollup) {
+		for (i = 0; i < UBER_ROLLUP_N_TIERS; i++) {
+			g_free(rollup->tiers[i].starts);
+			g_free(rollup->tiers[i].buckets);
+		}
+		g_slice_free(UberRollup, rollup);
+	}
+}
+
+/**
+ * uber_rollup_add_series:
+ * @rollup: An #UberRollup.
+ *
+ * Adds a new series to @rollup.  The new series has no values.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_rollup_add_series (UberRollup *rollup) /* IN */
+{
+	UberRollupTier *tier;
+	gint i;
+
+	g_return_if_fail(rollup != NULL);
+
+	for (i = 0; i < UBER_ROLLUP_N_TIERS; i++) {
+		tier = &rollup->tiers[i];
+		if (tier->len) {
+			tier->buckets = g_renew(UberRollupBucket, tier->buckets,
+			                        (gsize)(rollup->n_series + 1) * tier->len);
+			uber_rollup_bucket_reset(tier->buckets +
+			                         ((gsize)rollup->n_series * tier->len),
+			                         tier->len);
+		}
+	}
+	rollup->n_series++;
+}
+
+/**
+ * uber_rollup_tier_find:
+ * @tier: An #UberRollupTier.
+ * @n_series: The number of series.
+ * @start: The start time of a bucket.
+ *
+ * Finds the slot of the bucket starting at @start.  A bucket newer than
+ * any held is started, overwriting the oldest bucket.  Buckets are only
+ * ever started in order, so a late value whose bucket is not held is
+ * dropped.
+ *
+ * Returns: The slot of the bucket, or -1.
+ * Side effects: None.
+ */
+static gint
+uber_rollup_tier_find (UberRollupTier *tier,     /* IN */
+                       guint           n_series, /* IN */
+                       gint64          start)    /* IN */
+{
+	gint64 newest;
+	guint slot;
+	guint i;
+
+	newest = uber_rollup_tier_get_start(tier, 0);
+	if (start > newest) {
+		slot = tier->pos;
+		tier->starts[slot] = start;
+		for (i = 0; i < n_series; i++) {
+			uber_rollup_bucket_reset(tier->buckets + ((gsize)i * tier->len) + slot,
+			                         1);
+		}
+		tier->pos = (tier->pos + 1) % tier->len;
+		return slot;
+	}
+	for (i = 0; i < tier->len; i++) {
+		if (uber_rollup_tier_get_start(tier, i) <= start) {
+			if (uber_rollup_tier_get_start(tier, i) != start) {
+				break;
+			}
+			return (tier->pos + tier->len - 1 - i) % tier->len;
+		}
+	}
+	return -1;
+}
+
+/**
+ * uber_rollup_append_row:
+ * @rollup: An #UberRollup.
+ * @time: The time of the row.
+ * @row: An array of @rollup->n_series values.
+ *
+ * Adds a row of values to the bucket covering @time in every tier.
+ * Values that are %NAN are not counted.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_rollup_append_row (UberRollup    *rollup, /* IN */
+                        gint64         time,   /* IN */
+                        const gdouble *row)    /* IN */
+{
+	UberRollupBucket *bucket;
+	UberRollupTier *tier;
+	gint64 start;
+	gint slot;
+	guint i;
+	gint t;
+
+	g_return_if_fail(rollup != NULL);
+	g_return_if_fail(row != NULL || rollup->n_series == 0);
+
+	for (t = 0; t < UBER_ROLLUP_N_TIERS; t++) {
+		tier = &rollup->tiers[t];
+		if (!tier->len) {
+			continue;
+		}
+		/*
+		 * Round down to the start of the bucket, including for negative
+		 * times.
+		 */
+		start = time - (time % tier->width);
+		if (time < 0 && start != time) {
+			start -= tier->width;
+		}
+		if ((slot = uber_rollup_tier_find(tier, rollup->n_series, start)) < 0) {
+			continue;
+		}
+		bucket = tier->buckets + slot;
+		for (i = 0; i < rollup->n_series; i++, bucket += tier->len) {
+			if (isnan(row[i])) {
+				continue;
+			}
+			bucket->min = MIN(bucket->min, row[i]);
+			bucket->max = MAX(bucket->max, row[i]);
+			bucket->sum += row[i];
+			bucket->last = row[i];
+			bucket->count++;
+		}
+	}
+}
+
+/**
+ * uber_rollup_tier_resize:
+ * @tier: An #UberRollupTier.
+ * @n_series: The number of series.
+ * @len: The new number of buckets.
+ *
+ * Changes the number of buckets in @tier, keeping the newest buckets.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_rollup_tier_resize (UberRollupTier *tier,     /* IN */
+                         guint           n_series, /* IN */
+                         guint           len)      /* IN */
+{
+	UberRollupBucket *buckets = NULL;
+	gint64 *starts = NULL;
+	guint keep;
+	guint i;
+	guint j;
+
+	keep = MIN(len, tier->len);
+	if (len) {
+		starts = g_new(gint64, len);
+		buckets = g_new(UberRollupBucket, (gsize)n_series * len);
+		uber_rollup_bucket_reset(buckets, (gsize)n_series * len);
+		for (j = 0; j < len; j++) {
+			starts[j] = G_MININT64;
+		}
+		/*
+		 * Lay the kept buckets out oldest to newest from the first slot.
+		 */
+		for (j = 0; j < keep; j++) {
+			starts[keep - 1 - j] = uber_rollup_tier_get_start(tier, j);
+			for (i = 0; i < n_series; i++) {
+				buckets[((gsize)i * len) + keep - 1 - j] =
+					uber_rollup_tier_get_bucket(tier, i, j);
+			}
+		}
+	}
+	g_free(tier->starts);
+	g_free(tier->buckets);
+	tier->starts = starts;
+	tier->buckets = buckets;
+	tier->len = len;
+	tier->pos = len ? keep % len : 0;
+}
+
+/**
+ * uber_rollup_set_window:
+ * @rollup: An #UberRollup.
+ * @window: The span of time in microseconds to keep.
+ *
+ * Sizes every tier to hold enough buckets to cover @window.  Tiers that
+ * would need too many buckets are not kept.  The newest buckets of each
+ * kept tier are preserved.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_rollup_set_window (UberRollup *rollup, /* IN */
+                        gint64      window) /* IN */
+{
+	UberRollupTier *tier;
+	gint64 len;
+	gint i;
+
+	g_return_if_fail(rollup != NULL);
+	g_return_if_fail(window >= 0);
+
+	for (i = 0; i < UBER_ROLLUP_N_TIERS; i++) {
+		tier = &rollup->tiers[i];
+		/*
+		 * Keep an extra bucket for each partially visible bucket at the
+		 * edges of the window.
+		 */
+		len = ((window + tier->width - 1) / tier->width) + 2;
+		if (len > MAX_BUCKETS) {
+			len = 0;
+		}
+		if (len != tier->len) {
+			uber_rollup_tier_resize(tier, rollup->n_series, len);
+		}
+	}
+}
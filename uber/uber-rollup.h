@@ -0,0 +1,124 @@
+/* uber-rollup.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_ROLLUP_H__
+#define __UBER_ROLLUP_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define UBER_ROLLUP_N_TIERS (5)
+
+/**
+ * uber_rollup_tier_get_bucket:
+ * @tier: An #UberRollupTier.
+ * @series: The series index.
+ * @i: The index relative to the current position.
+ *
+ * Retrieves the bucket of @series at the given index.  Index 0 is the
+ * newest bucket.
+ *
+ * Returns: An #UberRollupBucket.
+ * Side effects: None.
+ */
+#define uber_rollup_tier_get_bucket(tier, series, i)                    \
+    ((tier)->buckets[((gsize)(series) * (tier)->len) +                  \
+                     ((((gint)(tier)->pos - 1 - (gint)(i)) >= 0) ?      \
+                      ((tier)->pos - 1 - (i)) :                         \
+                      ((tier)->len + ((tier)->pos - 1 - (i))))])
+
+/**
+ * uber_rollup_tier_get_start:
+ * @tier: An #UberRollupTier.
+ * @i: The index relative to the current position.
+ *
+ * Retrieves the start time of the bucket at the given index.
+ *
+ * Returns: The start time, or %G_MININT64 if the bucket is unused.
+ * Side effects: None.
+ */
+#define uber_rollup_tier_get_start(tier, i)                             \
+    ((tier)->starts[(((gint)(tier)->pos - 1 - (gint)(i)) >= 0) ?        \
+                    ((tier)->pos - 1 - (i)) :                           \
+                    ((tier)->len + ((tier)->pos - 1 - (i)))])
+
+/**
+ * UberRollupBucket:
+ * @min: The smallest value in the bucket.
+ * @max: The largest value in the bucket.
+ * @sum: The sum of the values in the bucket.
+ * @last: The newest value in the bucket.
+ * @count: The number of values in the bucket.
+ *
+ * A summary of the values of one series over the width of a bucket.
+ */
+typedef struct
+{
+	gdouble min;
+	gdouble max;
+	gdouble sum;
+	gdouble last;
+	guint   count;
+} UberRollupBucket;
+
+/**
+ * UberRollupTier:
+ * @width: The width of each bucket in microseconds.
+ * @len: The number of buckets held, or 0 if the tier is unused.
+ * @pos: The slot the next bucket will be started in.
+ * @starts: The start time of each bucket.
+ * @buckets: The buckets of every series, stored series after series.
+ *
+ * A ring of buckets of a single width.
+ */
+typedef struct
+{
+	gint64            width;
+	guint             len;
+	guint             pos;
+	gint64           *starts;
+	UberRollupBucket *buckets;
+} UberRollupTier;
+
+/**
+ * UberRollup:
+ * @tiers: The tiers, finest first.
+ * @n_series: The number of series.
+ *
+ * A pyramid of summaries of a set of series at increasingly coarse
+ * resolutions, maintained incrementally as rows are appended.
+ */
+typedef struct
+{
+	UberRollupTier tiers[UBER_ROLLUP_N_TIERS];
+	guint          n_series;
+} UberRollup;
+
+UberRollup* uber_rollup_new        (void);
+void        uber_rollup_free       (UberRollup    *rollup);
+void        uber_rollup_add_series (UberRollup    *rollup);
+void        uber_rollup_append_row (UberRollup    *rollup,
+                                    gint64         time,
+                                    const gdouble *row);
+void        uber_rollup_set_window (UberRollup    *rollup,
+                                    gint64         window);
+
+G_END_DECLS
+
+#endif /* __UBER_ROLLUP_H__ */
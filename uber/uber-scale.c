@@ -20,8 +20,19 @@
 #include "config.h"
 #endif
 
+#include <math.h>
+#include <string.h>
+
 #include "uber-scale.h"
 
+#define LOG_MIN_RATIO (1e-5)
+#define BISECT_STEPS  (48)
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
 /**
  * uber_scale_linear:
  * @range: An #UberRange.
@@ -30,7 +41,8 @@
  * @user_data: user data for scale.
  *
  * An #UberScale function to translate a value to the coordinate system in
- * a linear fashion.
+ * a linear fashion.  The result is the offset from the start of
+ * @pixel_range, with @range->begin mapping to zero.
  *
  * Returns: %TRUE if successful; otherwise %FALSE.
  * Side effects: None.
@@ -44,11 +56,716 @@ uber_scale_linear (const UberRange *range,       /* IN */
 	#define A (range->range)
 	#define B (pixel_range->range)
 	#define C (*value)
-	if (*value != 0.) {
-		*value = C * B / A;
+	if (A == 0.) {
+		*value = 0.;
+	} else {
+		*value = (C - range->begin) * B / A;
 	}
 	#undef A
 	#undef B
 	#undef C
 	return TRUE;
 }
+
+/**
+ * uber_scale_linear_scalar:
+ * @values: The values to translate.
+ * @pixels: (out): A location for the translated values.
+ * @n_values: The number of values.
+ * @offset: The value mapping to zero.
+ * @factor: The number of pixels per unit of value.
+ *
+ * Portable kernel for uber_scale_linear_batch().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_scale_linear_scalar (const gdouble *values,   /* IN */
+                          gdouble       *pixels,   /* OUT */
+                          guint          n_values, /* IN */
+                          gdouble        offset,   /* IN */
+                          gdouble        factor)   /* IN */
+{
+	guint i;
+
+	for (i = 0; i < n_values; i++) {
+		pixels[i] = (values[i] - offset) * factor;
+	}
+}
+
+#ifdef HAVE_X86_KERNELS
+/**
+ * uber_scale_linear_sse2:
+ * @values: The values to translate.
+ * @pixels: (out): A location for the translated values.
+ * @n_values: The number of values.
+ * @offset: The value mapping to zero.
+ * @factor: The number of pixels per unit of value.
+ *
+ * SSE2 kernel for uber_scale_linear_batch(), two values at a time.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+__attribute__((target("sse2")))
+static void
+uber_scale_linear_sse2 (const gdouble *values,   /* IN */
+                        gdouble       *pixels,   /* OUT */
+                        guint          n_values, /* IN */
+                        gdouble        offset,   /* IN */
+                        gdouble        factor)   /* IN */
+{
+	__m128d o = _mm_set1_pd(offset);
+	__m128d f = _mm_set1_pd(factor);
+	guint i;
+
+	for (i = 0; i + 2 <= n_values; i += 2) {
+		_mm_storeu_pd(pixels + i,
+		              _mm_mul_pd(_mm_sub_pd(_mm_loadu_pd(values + i), o), f));
+	}
+	uber_scale_linear_scalar(values + i, pixels + i, n_values - i,
+	                         offset, factor);
+}
+
+/**
+ * uber_scale_linear_avx2:
+ * @values: The values to translate.
+ * @pixels: (out): A location for the translated values.
+ * @n_values: The number of values.
+ * @offset: The value mapping to zero.
+ * @factor: The number of pixels per unit of value.
+ *
+ * AVX2 kernel for uber_scale_linear_batch(), four values at a time.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+__attribute__((target("avx2")))
+static void
+uber_scale_linear_avx2 (const gdouble *values,   /* IN */
+                        gdouble       *pixels,   /* OUT */
+                        guint          n_values, /* IN */
+                        gdouble        offset,   /* IN */
+                        gdouble        factor)   /* IN */
+{
+	__m256d o = _mm256_set1_pd(offset);
+	__m256d f = _mm256_set1_pd(factor);
+	guint i;
+
+	for (i = 0; i + 4 <= n_values; i += 4) {
+		_mm256_storeu_pd(pixels + i,
+		                 _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(values + i),
+		                                             o), f));
+	}
+	uber_scale_linear_scalar(values + i, pixels + i, n_values - i,
+	                         offset, factor);
+}
+#endif
+
+/**
+ * uber_scale_linear_batch:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @values: The values to translate.
+ * @pixels: (out): A location for @n_values translated values.
+ * @n_values: The number of values.
+ * @user_data: user data for scale.
+ *
+ * An #UberScaleBatch equivalent to uber_scale_linear().  The work is done
+ * with the widest vector instructions the CPU supports.  %NAN values are
+ * passed through unchanged.  @pixels may be the same array as @values.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_linear_batch (const UberRange *range,       /* IN */
+                         const UberRange *pixel_range, /* IN */
+                         const gdouble   *values,      /* IN */
+                         gdouble         *pixels,      /* OUT */
+                         guint            n_values,    /* IN */
+                         gpointer         user_data)   /* IN */
+{
+	gdouble factor;
+
+	g_return_if_fail(range != NULL);
+	g_return_if_fail(pixel_range != NULL);
+	g_return_if_fail(values != NULL || n_values == 0);
+	g_return_if_fail(pixels != NULL || n_values == 0);
+
+	/*
+	 * An empty range maps everything to the start of the pixel range, as
+	 * uber_scale_linear() does.  Multiplying by zero keeps %NAN intact.
+	 */
+	factor = (range->range == 0.) ? 0. : pixel_range->range / range->range;
+#ifdef HAVE_X86_KERNELS
+	if (__builtin_cpu_supports("avx2")) {
+		uber_scale_linear_avx2(values, pixels, n_values, range->begin, factor);
+		return;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		uber_scale_linear_sse2(values, pixels, n_values, range->begin, factor);
+		return;
+	}
+#endif
+	uber_scale_linear_scalar(values, pixels, n_values, range->begin, factor);
+}
+
+/**
+ * uber_scale_apply:
+ * @scale: An #UberScale.
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @values: The values to translate.
+ * @pixels: (out): A location for @n_values translated values.
+ * @n_values: The number of values.
+ * @user_data: user data for @scale.
+ *
+ * Translates a span of values with a per-value #UberScale, for scales that
+ * have no batch implementation.  %NAN values are passed through, and
+ * values that @scale fails to translate are set to %NAN.  @pixels may be
+ * the same array as @values.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_apply (UberScale        scale,       /* IN */
+                  const UberRange *range,       /* IN */
+                  const UberRange *pixel_range, /* IN */
+                  const gdouble   *values,      /* IN */
+                  gdouble         *pixels,      /* OUT */
+                  guint            n_values,    /* IN */
+                  gpointer         user_data)   /* IN */
+{
+	gdouble val;
+	guint i;
+
+	g_return_if_fail(scale != NULL);
+	g_return_if_fail(values != NULL || n_values == 0);
+	g_return_if_fail(pixels != NULL || n_values == 0);
+
+	for (i = 0; i < n_values; i++) {
+		val = values[i];
+		if (!isnan(val) && !scale(range, pixel_range, &val, user_data)) {
+			val = NAN;
+		}
+		pixels[i] = val;
+	}
+}
+
+/**
+ * uber_scale_log_bounds:
+ * @range: An #UberRange.
+ * @lo: (out): A location for log10 of the smallest value shown.
+ * @factor: (out): A location for the number of pixels per decade.
+ * @pixel_range: An #UberRange.
+ *
+ * Computes the constants shared by uber_scale_log() and its batch version.
+ * A range that does not start above zero is shown down to five decades
+ * below its end.
+ *
+ * Returns: %FALSE if nothing can be shown on a log scale.
+ * Side effects: None.
+ */
+static inline gboolean
+uber_scale_log_bounds (const UberRange *range,       /* IN */
+                       const UberRange *pixel_range, /* IN */
+                       gdouble         *lo,          /* OUT */
+                       gdouble         *factor)      /* OUT */
+{
+	gdouble begin;
+
+	if (range->end <= 0.) {
+		return FALSE;
+	}
+	begin = (range->begin > 0.) ? range->begin : range->end * LOG_MIN_RATIO;
+	if (begin >= range->end) {
+		return FALSE;
+	}
+	*lo = log10(begin);
+	*factor = pixel_range->range / (log10(range->end) - *lo);
+	return TRUE;
+}
+
+/**
+ * uber_scale_log:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @value: A pointer to the value to translate.
+ * @user_data: user data for scale.
+ *
+ * An #UberScale function to translate a value to the coordinate system in
+ * a logarithmic fashion, so that each decade takes the same space.
+ * Values at or below the smallest value shown sit at the start of
+ * @pixel_range.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_scale_log (const UberRange *range,       /* IN */
+                const UberRange *pixel_range, /* IN */
+                gdouble         *value,       /* IN/OUT */
+                gpointer         user_data)   /* IN */
+{
+	gdouble lo;
+	gdouble factor;
+	gdouble val;
+
+	if (isnan(*value)) {
+		return TRUE;
+	}
+	if (!uber_scale_log_bounds(range, pixel_range, &lo, &factor)) {
+		*value = 0.;
+		return TRUE;
+	}
+	val = log10(*value);
+	*value = (val > lo) ? (val - lo) * factor : 0.;
+	return TRUE;
+}
+
+/**
+ * uber_scale_log_batch:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @values: The values to translate.
+ * @pixels: (out): A location for @n_values translated values.
+ * @n_values: The number of values.
+ * @user_data: user data for scale.
+ *
+ * An #UberScaleBatch equivalent to uber_scale_log().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_log_batch (const UberRange *range,       /* IN */
+                      const UberRange *pixel_range, /* IN */
+                      const gdouble   *values,      /* IN */
+                      gdouble         *pixels,      /* OUT */
+                      guint            n_values,    /* IN */
+                      gpointer         user_data)   /* IN */
+{
+	gdouble lo;
+	gdouble factor;
+	gdouble val;
+	guint i;
+
+	g_return_if_fail(range != NULL);
+	g_return_if_fail(pixel_range != NULL);
+
+	if (!uber_scale_log_bounds(range, pixel_range, &lo, &factor)) {
+		for (i = 0; i < n_values; i++) {
+			pixels[i] = isnan(values[i]) ? values[i] : 0.;
+		}
+		return;
+	}
+	for (i = 0; i < n_values; i++) {
+		val = log10(values[i]);
+		pixels[i] = isnan(values[i]) ? values[i]
+		          : (val > lo) ? (val - lo) * factor : 0.;
+	}
+}
+
+/**
+ * uber_scale_symlog_transform:
+ * @value: A value.
+ * @threshold: The linear threshold.
+ *
+ * Compresses @value logarithmically away from zero while staying close to
+ * linear within @threshold of zero, where a plain logarithm would diverge.
+ *
+ * Returns: The transformed value.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_scale_symlog_transform (gdouble value,     /* IN */
+                             gdouble threshold) /* IN */
+{
+	return copysign(log10(1. + (fabs(value) / threshold)), value);
+}
+
+/**
+ * uber_scale_symlog_threshold:
+ * @user_data: A pointer to a #gdouble, or %NULL.
+ *
+ * Retrieves the linear threshold of a symmetric log scale.
+ *
+ * Returns: The threshold, which defaults to 1.
+ * Side effects: None.
+ */
+static inline gdouble
+uber_scale_symlog_threshold (gpointer user_data) /* IN */
+{
+	gdouble *threshold = user_data;
+
+	return (threshold && *threshold > 0.) ? *threshold : 1.;
+}
+
+/**
+ * uber_scale_symlog:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @value: A pointer to the value to translate.
+ * @user_data: A pointer to a #gdouble linear threshold, or %NULL for 1.
+ *
+ * An #UberScale function to translate a value to the coordinate system in
+ * a symmetric logarithmic fashion.  Unlike uber_scale_log(), zero and
+ * negative values are shown, with values within the threshold of zero
+ * scaled roughly linearly.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_scale_symlog (const UberRange *range,       /* IN */
+                   const UberRange *pixel_range, /* IN */
+                   gdouble         *value,       /* IN/OUT */
+                   gpointer         user_data)   /* IN */
+{
+	gdouble threshold;
+	gdouble lo;
+	gdouble hi;
+
+	threshold = uber_scale_symlog_threshold(user_data);
+	lo = uber_scale_symlog_transform(range->begin, threshold);
+	hi = uber_scale_symlog_transform(range->end, threshold);
+	if (hi == lo) {
+		*value = 0.;
+	} else {
+		*value = (uber_scale_symlog_transform(*value, threshold) - lo)
+		       * pixel_range->range / (hi - lo);
+	}
+	return TRUE;
+}
+
+/**
+ * uber_scale_symlog_batch:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @values: The values to translate.
+ * @pixels: (out): A location for @n_values translated values.
+ * @n_values: The number of values.
+ * @user_data: A pointer to a #gdouble linear threshold, or %NULL for 1.
+ *
+ * An #UberScaleBatch equivalent to uber_scale_symlog().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_symlog_batch (const UberRange *range,       /* IN */
+                         const UberRange *pixel_range, /* IN */
+                         const gdouble   *values,      /* IN */
+                         gdouble         *pixels,      /* OUT */
+                         guint            n_values,    /* IN */
+                         gpointer         user_data)   /* IN */
+{
+	gdouble threshold;
+	gdouble factor;
+	gdouble lo;
+	gdouble hi;
+	guint i;
+
+	g_return_if_fail(range != NULL);
+	g_return_if_fail(pixel_range != NULL);
+
+	threshold = uber_scale_symlog_threshold(user_data);
+	lo = uber_scale_symlog_transform(range->begin, threshold);
+	hi = uber_scale_symlog_transform(range->end, threshold);
+	factor = (hi == lo) ? 0. : pixel_range->range / (hi - lo);
+	for (i = 0; i < n_values; i++) {
+		pixels[i] = (uber_scale_symlog_transform(values[i], threshold) - lo)
+		          * factor;
+	}
+}
+
+/**
+ * uber_scale_percentile_new:
+ * @low: The lower percentile, between 0 and 100.
+ * @high: The upper percentile, between 0 and 100.
+ *
+ * Creates the state for uber_scale_percentile().  Until
+ * uber_scale_percentile_update() is called the scale is linear over the
+ * range of the graph.
+ *
+ * Returns: A new #UberScalePercentile which should be freed with
+ *   uber_scale_percentile_free().
+ * Side effects: None.
+ */
+UberScalePercentile*
+uber_scale_percentile_new (gdouble low,  /* IN */
+                           gdouble high) /* IN */
+{
+	UberScalePercentile *percentile;
+
+	g_return_val_if_fail(low >= 0. && low <= high && high <= 100., NULL);
+
+	percentile = g_slice_new0(UberScalePercentile);
+	percentile->low = low;
+	percentile->high = high;
+	return percentile;
+}
+
+/**
+ * uber_scale_percentile_free:
+ * @percentile: An #UberScalePercentile.
+ *
+ * Frees @percentile.  Suitable as the #GDestroyNotify for the scale data.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_percentile_free (UberScalePercentile *percentile) /* IN */
+{
+	if (percentile) {
+		g_free(percentile->scratch);
+		g_slice_free(UberScalePercentile, percentile);
+	}
+}
+
+/**
+ * uber_scale_select:
+ * @values: An array of #gdouble without %NAN.
+ * @n_values: The number of elements in @values.
+ * @k: The rank to select.
+ *
+ * Partially orders @values with quickselect so that element @k is the one
+ * that would be there if @values were sorted.
+ *
+ * Returns: The value of rank @k.
+ * Side effects: None.
+ */
+static gdouble
+uber_scale_select (gdouble *values,   /* IN/OUT */
+                   guint    n_values, /* IN */
+                   guint    k)        /* IN */
+{
+	gdouble pivot;
+	gdouble tmp;
+	guint left = 0;
+	guint right = n_values - 1;
+	guint i;
+	guint j;
+
+	while (left < right) {
+		pivot = values[left + ((right - left) / 2)];
+		i = left;
+		j = right;
+		while (i <= j) {
+			while (values[i] < pivot) {
+				i++;
+			}
+			while (values[j] > pivot) {
+				j--;
+			}
+			if (i <= j) {
+				tmp = values[i];
+				values[i] = values[j];
+				values[j] = tmp;
+				i++;
+				if (j == 0) {
+					break;
+				}
+				j--;
+			}
+		}
+		if (k <= j) {
+			right = j;
+		} else if (k >= i) {
+			left = i;
+		} else {
+			break;
+		}
+	}
+	return values[k];
+}
+
+/**
+ * uber_scale_percentile_update:
+ * @percentile: An #UberScalePercentile.
+ * @values: The values to take percentiles of.
+ * @n_values: The number of elements in @values.
+ *
+ * Recomputes the clamp range of @percentile from @values in linear time.
+ * %NAN values are ignored.  If no values remain the clamp range is left
+ * unchanged.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_percentile_update (UberScalePercentile *percentile, /* IN */
+                              const gdouble       *values,     /* IN */
+                              guint                n_values)   /* IN */
+{
+	guint n = 0;
+	guint i;
+
+	g_return_if_fail(percentile != NULL);
+	g_return_if_fail(values != NULL || n_values == 0);
+
+	if (n_values > percentile->scratch_len) {
+		percentile->scratch = g_renew(gdouble, percentile->scratch, n_values);
+		percentile->scratch_len = n_values;
+	}
+	for (i = 0; i < n_values; i++) {
+		if (!isnan(values[i])) {
+			percentile->scratch[n++] = values[i];
+		}
+	}
+	if (!n) {
+		return;
+	}
+	percentile->clamp.begin =
+		uber_scale_select(percentile->scratch, n,
+		                  (guint)((n - 1) * percentile->low / 100.));
+	percentile->clamp.end =
+		uber_scale_select(percentile->scratch, n,
+		                  (guint)ceil((n - 1) * percentile->high / 100.));
+	percentile->clamp.range = percentile->clamp.end - percentile->clamp.begin;
+	percentile->valid = TRUE;
+}
+
+/**
+ * uber_scale_percentile_get_range:
+ * @percentile: An #UberScalePercentile.
+ * @range: The range of the graph.
+ *
+ * Retrieves the range that uber_scale_percentile() maps onto the pixel
+ * range.  Graphs report it as their Y range so the axis labels agree with
+ * what is drawn.
+ *
+ * Returns: The clamp range, or @range if none was computed yet.
+ * Side effects: None.
+ */
+const UberRange*
+uber_scale_percentile_get_range (UberScalePercentile *percentile, /* IN */
+                                 const UberRange     *range)      /* IN */
+{
+	g_return_val_if_fail(percentile != NULL, range);
+
+	return percentile->valid ? &percentile->clamp : range;
+}
+
+/**
+ * uber_scale_percentile:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @value: A pointer to the value to translate.
+ * @user_data: An #UberScalePercentile.
+ *
+ * An #UberScale function that scales linearly between two percentiles of
+ * the data, so that rare outliers do not squash everything else.  Values
+ * outside the percentiles are clamped to the edges of @pixel_range.
+ *
+ * Returns: %TRUE if successful; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_scale_percentile (const UberRange *range,       /* IN */
+                       const UberRange *pixel_range, /* IN */
+                       gdouble         *value,       /* IN/OUT */
+                       gpointer         user_data)   /* IN */
+{
+	g_return_val_if_fail(user_data != NULL, FALSE);
+
+	range = uber_scale_percentile_get_range(user_data, range);
+	uber_scale_linear(range, pixel_range, value, NULL);
+	*value = CLAMP(*value, 0., pixel_range->range);
+	return TRUE;
+}
+
+/**
+ * uber_scale_percentile_batch:
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @values: The values to translate.
+ * @pixels: (out): A location for @n_values translated values.
+ * @n_values: The number of values.
+ * @user_data: An #UberScalePercentile.
+ *
+ * An #UberScaleBatch equivalent to uber_scale_percentile().
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scale_percentile_batch (const UberRange *range,       /* IN */
+                             const UberRange *pixel_range, /* IN */
+                             const gdouble   *values,      /* IN */
+                             gdouble         *pixels,      /* OUT */
+                             guint            n_values,    /* IN */
+                             gpointer         user_data)   /* IN */
+{
+	guint i;
+
+	g_return_if_fail(user_data != NULL);
+	g_return_if_fail(pixel_range != NULL);
+
+	range = uber_scale_percentile_get_range(user_data, range);
+	uber_scale_linear_batch(range, pixel_range, values, pixels, n_values,
+	                        NULL);
+	for (i = 0; i < n_values; i++) {
+		pixels[i] = CLAMP(pixels[i], 0., pixel_range->range);
+	}
+}
+
+/**
+ * uber_scale_invert:
+ * @scale: An #UberScale.
+ * @range: An #UberRange.
+ * @pixel_range: An #UberRange.
+ * @offset: A pixel offset from the start of @pixel_range.
+ * @user_data: user data for @scale.
+ *
+ * Finds the value that @scale translates to @offset.  The scale must be
+ * non-decreasing over @range; the value is found by bisection, so any such
+ * scale can be inverted without knowing its formula.  Linear scales are
+ * inverted directly.
+ *
+ * Where a run of values all translate to @offset, as below the floor of
+ * uber_scale_log(), the largest of them is returned.  That is the value the
+ * pixel actually stands for.
+ *
+ * Returns: The value within @range.
+ * Side effects: None.
+ */
+gdouble
+uber_scale_invert (UberScale        scale,       /* IN */
+                   const UberRange *range,       /* IN */
+                   const UberRange *pixel_range, /* IN */
+                   gdouble          offset,      /* IN */
+                   gpointer         user_data)   /* IN */
+{
+	gdouble lo;
+	gdouble hi;
+	gdouble mid;
+	gdouble val;
+	gint i;
+
+	g_return_val_if_fail(range != NULL, 0.);
+	g_return_val_if_fail(pixel_range != NULL, 0.);
+
+	if (!scale || scale == uber_scale_linear) {
+		if (pixel_range->range == 0.) {
+			return range->begin;
+		}
+		return range->begin + (range->range * offset / pixel_range->range);
+	}
+	lo = range->begin;
+	hi = range->end;
+	for (i = 0; i < BISECT_STEPS; i++) {
+		mid = lo + ((hi - lo) / 2.);
+		val = mid;
+		if (!scale(range, pixel_range, &val, user_data) || val <= offset) {
+			lo = mid;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo + ((hi - lo) / 2.);
+}
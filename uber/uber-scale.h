@@ -28,10 +28,94 @@ typedef gboolean (*UberScale) (const UberRange *range,
                                gdouble         *value,
                                gpointer         user_data);
 
-gboolean uber_scale_linear (const UberRange *range,
-                            const UberRange *pixel_range,
-                            gdouble         *value,
-                            gpointer         user_data);
+typedef void (*UberScaleBatch) (const UberRange *range,
+                                const UberRange *pixel_range,
+                                const gdouble   *values,
+                                gdouble         *pixels,
+                                guint            n_values,
+                                gpointer         user_data);
+
+/**
+ * UberScalePercentile:
+ * @low: The lower percentile, between 0 and 100.
+ * @high: The upper percentile, between 0 and 100.
+ * @clamp: The values at @low and @high in the last update.
+ * @valid: If @clamp has been computed.
+ *
+ * State for uber_scale_percentile(), passed as its user data.
+ */
+typedef struct
+{
+	gdouble    low;
+	gdouble    high;
+	UberRange  clamp;
+	gboolean   valid;
+
+	/*< private >*/
+	gdouble   *scratch;
+	guint      scratch_len;
+} UberScalePercentile;
+
+gboolean uber_scale_linear       (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  gdouble         *value,
+                                  gpointer         user_data);
+void     uber_scale_linear_batch (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  const gdouble   *values,
+                                  gdouble         *pixels,
+                                  guint            n_values,
+                                  gpointer         user_data);
+gboolean uber_scale_log          (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  gdouble         *value,
+                                  gpointer         user_data);
+void     uber_scale_log_batch    (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  const gdouble   *values,
+                                  gdouble         *pixels,
+                                  guint            n_values,
+                                  gpointer         user_data);
+gboolean uber_scale_symlog       (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  gdouble         *value,
+                                  gpointer         user_data);
+void     uber_scale_symlog_batch (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  const gdouble   *values,
+                                  gdouble         *pixels,
+                                  guint            n_values,
+                                  gpointer         user_data);
+gboolean uber_scale_percentile   (const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  gdouble         *value,
+                                  gpointer         user_data);
+void     uber_scale_percentile_batch (const UberRange *range,
+                                      const UberRange *pixel_range,
+                                      const gdouble   *values,
+                                      gdouble         *pixels,
+                                      guint            n_values,
+                                      gpointer         user_data);
+UberScalePercentile* uber_scale_percentile_new       (gdouble              low,
+                                                      gdouble              high);
+void                 uber_scale_percentile_free      (UberScalePercentile *percentile);
+void                 uber_scale_percentile_update    (UberScalePercentile *percentile,
+                                                      const gdouble       *values,
+                                                      guint                n_values);
+const UberRange*     uber_scale_percentile_get_range (UberScalePercentile *percentile,
+                                                      const UberRange     *range);
+gdouble  uber_scale_invert       (UberScale        scale,
+                                  const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  gdouble          offset,
+                                  gpointer         user_data);
+void     uber_scale_apply        (UberScale        scale,
+                                  const UberRange *range,
+                                  const UberRange *pixel_range,
+                                  const gdouble   *values,
+                                  gdouble         *pixels,
+                                  guint            n_values,
+                                  gpointer         user_data);
 
 G_END_DECLS
 
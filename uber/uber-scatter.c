@@ -28,7 +28,9 @@
 #include "uber-range.h"
 #include "g-ring.h"
 
-#define RADIUS 3
+#define RADIUS        3
+#define SPRITE_ORIGIN (RADIUS + 1)
+#define SPRITE_SIZE   ((RADIUS * 2) + 3)
 
 /**
  * SECTION:uber-scatter.h
@@ -36,6 +38,10 @@
  * @short_description:
  *
  * Section overview.
+ *
+ * Points are drawn by copying a small pre-rendered sprite of the dot and
+ * its shadow to whole pixel positions.  Points of a column that land on
+ * the same pixel are drawn once.
  */
 
 G_DEFINE_TYPE(UberScatter, uber_scatter, UBER_TYPE_GRAPH)
@@ -50,6 +56,16 @@ struct _UberScatterPrivate
 	UberScatterFunc  func;
 	gpointer         func_user_data;
 	GDestroyNotify   func_destroy;
+	UberScale        scale;
+	UberScaleBatch   scale_batch;
+	gpointer         scale_data;
+	GDestroyNotify   scale_notify;
+	gdouble         *scaled;      /* Scratch for one column once scaled. */
+	guint            scaled_len;
+	cairo_surface_t *sprite;      /* Dot and shadow, centered on SPRITE_ORIGIN. */
+	GdkRGBA          sprite_color;
+	guint8          *drawn;       /* Rows of a column already drawn. */
+	guint            drawn_len;
 };
 
 /**
@@ -115,7 +131,7 @@ uber_scatter_destroy_array (gpointer data) /* IN */
 {
 	GArray **ar = data;
 
-	if (ar) {
+	if (ar && *ar) {
 		g_array_unref(*ar);
 	}
 }
@@ -142,18 +158,186 @@ uber_scatter_set_stride (UberGraph *graph,  /* IN */
 		return;
 	}
 	priv->stride = stride;
+	/*
+	 * Keep the most recent samples if we already have a buffer.
+	 */
 	if (priv->raw_data) {
-		g_ring_unref(priv->raw_data);
+		g_ring_resize(priv->raw_data, stride);
+		return;
 	}
 	priv->raw_data = g_ring_sized_new(sizeof(GArray*), stride,
 	                                  uber_scatter_destroy_array);
 }
 
+/**
+ * uber_scatter_scale_column:
+ * @scatter: A #UberScatter.
+ * @pixel_range: The pixel range to translate into.
+ * @ar: A #GArray of #gdouble values.
+ *
+ * Translates every value of @ar to a Y coordinate within @pixel_range in
+ * one call to the scale.
+ *
+ * Returns: An array of @ar->len coordinates owned by @scatter.  Values the
+ *   scale cannot translate are %NAN.
+ * Side effects: None.
+ */
+static gdouble*
+uber_scatter_scale_column (UberScatter     *scatter,     /* IN */
+                           const UberRange *pixel_range, /* IN */
+                           GArray          *ar)          /* IN */
+{
+	UberScatterPrivate *priv;
+	gint i;
+
+	priv = scatter->priv;
+	if (ar->len > priv->scaled_len) {
+		priv->scaled = g_renew(gdouble, priv->scaled, ar->len);
+		priv->scaled_len = ar->len;
+	}
+	if (priv->scale_batch) {
+		priv->scale_batch(&priv->range, pixel_range, (gdouble *)ar->data,
+		                  priv->scaled, ar->len, priv->scale_data);
+	} else {
+		uber_scale_apply(priv->scale, &priv->range, pixel_range,
+		                 (gdouble *)ar->data, priv->scaled, ar->len,
+		                 priv->scale_data);
+	}
+	/*
+	 * Scales measure up from the bottom of the pixel range.
+	 */
+	for (i = 0; i < ar->len; i++) {
+		priv->scaled[i] = pixel_range->end - priv->scaled[i];
+	}
+	return priv->scaled;
+}
+
+/**
+ * uber_scatter_get_sprite:
+ * @scatter: A #UberScatter.
+ * @cr: The #cairo_t that will be drawn to.
+ *
+ * Retrieves the sprite that points are drawn with, rendering it again if
+ * the foreground color or the kind of surface drawn to has changed.
+ *
+ * Returns: A cairo surface owned by @scatter.
+ * Side effects: None.
+ */
+static cairo_surface_t*
+uber_scatter_get_sprite (UberScatter *scatter, /* IN */
+                         cairo_t     *cr)      /* IN */
+{
+	UberScatterPrivate *priv;
+	GtkStyleContext *style;
+	GdkRGBA color;
+	cairo_t *sprite_cr;
+
+	priv = scatter->priv;
+	color = priv->fg_color;
+	if (!priv->fg_color_set) {
+		style = gtk_widget_get_style_context(GTK_WIDGET(scatter));
+		gtk_style_context_get_color(style, GTK_STATE_FLAG_SELECTED, &color);
+	}
+	if (priv->sprite &&
+	    gdk_rgba_equal(&priv->sprite_color, &color) &&
+	    cairo_surface_get_type(priv->sprite) ==
+	    cairo_surface_get_type(cairo_get_target(cr))) {
+		return priv->sprite;
+	}
+	if (priv->sprite) {
+		cairo_surface_destroy(priv->sprite);
+	}
+	priv->sprite_color = color;
+	priv->sprite = cairo_surface_create_similar(cairo_get_target(cr),
+	                                            CAIRO_CONTENT_COLOR_ALPHA,
+	                                            SPRITE_SIZE, SPRITE_SIZE);
+	sprite_cr = cairo_create(priv->sprite);
+	/*
+	 * Shadow.
+	 */
+	cairo_arc(sprite_cr, SPRITE_ORIGIN + .5, SPRITE_ORIGIN + .5, RADIUS,
+	          0, 2 * M_PI);
+	cairo_set_source_rgb(sprite_cr, .1, .1, .1);
+	cairo_fill(sprite_cr);
+	/*
+	 * Foreground.
+	 */
+	cairo_arc(sprite_cr, SPRITE_ORIGIN, SPRITE_ORIGIN, RADIUS, 0, 2 * M_PI);
+	cairo_set_source_rgb(sprite_cr, color.red, color.green, color.blue);
+	cairo_fill(sprite_cr);
+	cairo_destroy(sprite_cr);
+	return priv->sprite;
+}
+
+/**
+ * uber_scatter_render_column:
+ * @scatter: A #UberScatter.
+ * @cr: A #cairo_t.
+ * @area: The content area.
+ * @pixel_range: The pixel range to translate values into.
+ * @x: The center of the column.
+ * @ar: A #GArray of #gdouble values.
+ *
+ * Stamps the sprite for each value of @ar.  Values that round to a row
+ * already drawn in this column are skipped, as they would be hidden.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_scatter_render_column (UberScatter     *scatter,     /* IN */
+                            cairo_t         *cr,          /* IN */
+                            GdkRectangle    *area,        /* IN */
+                            const UberRange *pixel_range, /* IN */
+                            gdouble          x,           /* IN */
+                            GArray          *ar)          /* IN */
+{
+	UberScatterPrivate *priv;
+	cairo_surface_t *sprite;
+	gdouble *ys;
+	gint row;
+	gint sx;
+	gint i;
+
+	priv = scatter->priv;
+	if (!ar->len || area->height <= 0) {
+		return;
+	}
+	if (area->height > priv->drawn_len) {
+		priv->drawn = g_renew(guint8, priv->drawn, area->height);
+		priv->drawn_len = area->height;
+	}
+	memset(priv->drawn, 0, area->height);
+	sprite = uber_scatter_get_sprite(scatter, cr);
+	sx = (gint)floor(x + .5) - SPRITE_ORIGIN;
+	ys = uber_scatter_scale_column(scatter, pixel_range, ar);
+	for (i = 0; i < ar->len; i++) {
+		if (isnan(ys[i])) {
+			continue;
+		}
+		row = (gint)floor(ys[i] + .5) - area->y;
+		if (row >= 0 && row < area->height) {
+			if (priv->drawn[row]) {
+				continue;
+			}
+			priv->drawn[row] = TRUE;
+		}
+		/*
+		 * Whole pixel offsets keep this a plain copy of the sprite.
+		 */
+		cairo_set_source_surface(cr, sprite, sx,
+		                         row + area->y - SPRITE_ORIGIN);
+		cairo_rectangle(cr, sx, row + area->y - SPRITE_ORIGIN,
+		                SPRITE_SIZE, SPRITE_SIZE);
+		cairo_fill(cr);
+	}
+}
+
 /**
  * uber_scatter_render:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Draws every column, the newest ending at @epoch.
  *
  * Returns: None.
  * Side effects: None.
@@ -167,22 +351,13 @@ uber_scatter_render (UberGraph     *graph, /* IN */
 {
 	UberScatterPrivate *priv;
 	UberRange pixel_range;
-	GtkStyleContext *style;
-	GdkRGBA color;
 	GArray *ar;
 	gdouble x;
-	gdouble y;
 	gint i;
-	gint j;
 
 	g_return_if_fail(UBER_IS_SCATTER(graph));
 
 	priv = UBER_SCATTER(graph)->priv;
-	color = priv->fg_color;
-	if (!priv->fg_color_set) {
-		style = gtk_widget_get_style_context(GTK_WIDGET(graph));
-		gtk_style_context_get_color(style, GTK_STATE_FLAG_SELECTED, &color);
-	}
 	/*
 	 * Calculate ranges.
 	 */
@@ -197,26 +372,8 @@ uber_scatter_render (UberGraph     *graph, /* IN */
 			continue;
 		}
 		x = epoch - (i * each) - (each / 2.);
-		for (j = 0; j < ar->len; j++) {
-			y = g_array_index(ar, gdouble, j);
-//			g_debug("Raw ==> %f", y);
-			uber_scale_linear(&priv->range, &pixel_range, &y, NULL);
-			/*
-			 * Shadow.
-			 */
-			cairo_arc(cr, x + .5, y + .5, RADIUS, 0, 2 * M_PI);
-			cairo_set_source_rgb(cr, .1, .1, .1);
-			cairo_fill(cr);
-			/*
-			 * Foreground.
-			 */
-			cairo_arc(cr, x, y, RADIUS, 0, 2 * M_PI);
-			cairo_set_source_rgb(cr,
-			                     color.red,
-			                     color.green,
-			                     color.blue);
-			cairo_fill(cr);
-		}
+		uber_scatter_render_column(UBER_SCATTER(graph), cr, area,
+		                           &pixel_range, x, ar);
 	}
 }
 
@@ -224,7 +381,7 @@ uber_scatter_render (UberGraph     *graph, /* IN */
  * uber_scatter_render_fast:
  * @graph: A #UberGraph.
  *
- * XXX
+ * Draws the newest column, ending at @epoch.
  *
  * Returns: None.
  * Side effects: None.
@@ -238,21 +395,11 @@ uber_scatter_render_fast (UberGraph    *graph, /* IN */
 {
 	UberScatterPrivate *priv;
 	UberRange pixel_range;
-	GtkStyleContext *style;
-	GdkRGBA color;
 	GArray *ar;
-	gdouble x;
-	gdouble y;
-	gint i;
 
 	g_return_if_fail(UBER_IS_SCATTER(graph));
 
 	priv = UBER_SCATTER(graph)->priv;
-	color = priv->fg_color;
-	if (!priv->fg_color_set) {
-		style = gtk_widget_get_style_context(GTK_WIDGET(graph));
-		gtk_style_context_get_color(style, GTK_STATE_FLAG_SELECTED, &color);
-	}
 	/*
 	 * Calculate ranges.
 	 */
@@ -267,37 +414,10 @@ uber_scatter_render_fast (UberGraph    *graph, /* IN */
 		return;
 	}
 	/*
-	 * Calculate X position (Center of this chunk).
-	 */
-	x = epoch - (each / 2.);
-	/*
-	 * Draw scatter dots.
+	 * Draw scatter dots at the center of this chunk.
 	 */
-	for (i = 0; i < ar->len; i++) {
-		/*
-		 * Scale the value to our graph coordinates.
-		 */
-		y = g_array_index(ar, gdouble, i);
-		/*
-		 * XXX: Support multiple scales.
-		 */
-		uber_scale_linear(&priv->range, &pixel_range, &y, NULL);
-		/*
-		 * Shadow.
-		 */
-		cairo_arc(cr, x + .5, y + .5, RADIUS, 0, 2 * M_PI);
-		cairo_set_source_rgb(cr, .1, .1, .1);
-		cairo_fill(cr);
-		/*
-		 * Foreground.
-		 */
-		cairo_arc(cr, x, y, RADIUS, 0, 2 * M_PI);
-		cairo_set_source_rgb(cr,
-		                     color.red,
-		                     color.green,
-		                     color.blue);
-		cairo_fill(cr);
-	}
+	uber_scatter_render_column(UBER_SCATTER(graph), cr, area, &pixel_range,
+	                           epoch - (each / 2.), ar);
 }
 
 /**
@@ -306,7 +426,7 @@ uber_scatter_render_fast (UberGraph    *graph, /* IN */
  *
  * Retrieve the next data point for the graph.
  *
- * Returns: None.
+ * Returns: %TRUE if the data func supplied any points.
  * Side effects: None.
  */
 static gboolean
@@ -323,7 +443,7 @@ uber_scatter_get_next_data (UberGraph *graph) /* IN */
 			array = NULL;
 		}
 		g_ring_append_val(priv->raw_data, array);
-		return TRUE;
+		return (array != NULL && array->len > 0);
 	}
 	return FALSE;
 }
@@ -355,6 +475,91 @@ uber_scatter_set_fg_color (UberScatter    *scatter, /* IN */
 	}
 }
 
+/**
+ * uber_scatter_set_scale:
+ * @scatter: A #UberScatter.
+ * @scale: An #UberScale, or %NULL for uber_scale_linear().
+ * @scale_batch: The #UberScaleBatch equivalent of @scale, or %NULL.
+ * @user_data: user data for @scale and @scale_batch.
+ * @notify: A #GDestroyNotify for @user_data, or %NULL.
+ *
+ * Sets the scale used to place values vertically.  @scale_batch is used to
+ * translate a column of values at once when it is provided.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scatter_set_scale (UberScatter    *scatter,     /* IN */
+                        UberScale       scale,       /* IN */
+                        UberScaleBatch  scale_batch, /* IN */
+                        gpointer        user_data,   /* IN */
+                        GDestroyNotify  notify)      /* IN */
+{
+	UberScatterPrivate *priv;
+
+	g_return_if_fail(UBER_IS_SCATTER(scatter));
+
+	priv = scatter->priv;
+	if (priv->scale_notify) {
+		priv->scale_notify(priv->scale_data);
+	}
+	if (!scale) {
+		scale = uber_scale_linear;
+		scale_batch = uber_scale_linear_batch;
+	}
+	priv->scale = scale;
+	priv->scale_batch = scale_batch;
+	priv->scale_data = user_data;
+	priv->scale_notify = notify;
+	uber_graph_redraw(UBER_GRAPH(scatter));
+}
+
+/**
+ * uber_scatter_get_yrange:
+ * @graph: A #UberGraph.
+ * @range: (out): A location for the range.
+ *
+ * Retrieves the range of values shown vertically.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_scatter_get_yrange (UberGraph *graph, /* IN */
+                         UberRange *range) /* OUT */
+{
+	g_return_if_fail(UBER_IS_SCATTER(graph));
+	g_return_if_fail(range != NULL);
+
+	*range = UBER_SCATTER(graph)->priv->range;
+}
+
+/**
+ * uber_scatter_get_yscale:
+ * @graph: A #UberGraph.
+ * @scale: (out): A location for the #UberScale.
+ * @scale_data: (out): A location for the user data of @scale.
+ *
+ * Retrieves the scale used to place values vertically.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_scatter_get_yscale (UberGraph *graph,      /* IN */
+                         UberScale *scale,      /* OUT */
+                         gpointer  *scale_data) /* OUT */
+{
+	UberScatterPrivate *priv;
+
+	g_return_if_fail(UBER_IS_SCATTER(graph));
+
+	priv = UBER_SCATTER(graph)->priv;
+	*scale = priv->scale;
+	*scale_data = priv->scale_data;
+}
+
 /**
  * uber_scatter_finalize:
  * @object: A #UberScatter.
@@ -368,6 +573,26 @@ uber_scatter_set_fg_color (UberScatter    *scatter, /* IN */
 static void
 uber_scatter_finalize (GObject *object) /* IN */
 {
+	UberScatterPrivate *priv;
+
+	priv = UBER_SCATTER(object)->priv;
+	/*
+	 * Release the stored samples.
+	 */
+	if (priv->raw_data) {
+		g_ring_unref(priv->raw_data);
+	}
+	if (priv->func_destroy) {
+		priv->func_destroy(priv->func_user_data);
+	}
+	if (priv->scale_notify) {
+		priv->scale_notify(priv->scale_data);
+	}
+	g_free(priv->scaled);
+	g_free(priv->drawn);
+	if (priv->sprite) {
+		cairo_surface_destroy(priv->sprite);
+	}
 	G_OBJECT_CLASS(uber_scatter_parent_class)->finalize(object);
 }
 
@@ -395,6 +620,8 @@ uber_scatter_class_init (UberScatterClass *klass) /* IN */
 	graph_class->render_fast = uber_scatter_render_fast;
 	graph_class->set_stride = uber_scatter_set_stride;
 	graph_class->get_next_data = uber_scatter_get_next_data;
+	graph_class->get_yrange = uber_scatter_get_yrange;
+	graph_class->get_yscale = uber_scatter_get_yscale;
 }
 
 /**
@@ -419,4 +646,6 @@ uber_scatter_init (UberScatter *scatter) /* IN */
 	priv->range.begin = 0.;
 	priv->range.end = 15000.;
 	priv->range.range = priv->range.end - priv->range.begin;
+	priv->scale = uber_scale_linear;
+	priv->scale_batch = uber_scale_linear_batch;
 }
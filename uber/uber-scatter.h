@@ -60,6 +60,11 @@ void       uber_scatter_set_data_func (UberScatter     *scatter,
                                        UberScatterFunc  func,
                                        gpointer         user_data,
                                        GDestroyNotify   destroy);
+void       uber_scatter_set_scale     (UberScatter     *scatter,
+                                       UberScale        scale,
+                                       UberScaleBatch   scale_batch,
+                                       gpointer         user_data,
+                                       GDestroyNotify   notify);
 
 G_END_DECLS
 
@@ -0,0 +1,294 @@
+/* uber-scheduler.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "uber-scheduler.h"
+
+/**
+ * SECTION:uber-scheduler
+ * @title: UberScheduler
+ * @short_description: Shared periodic callbacks.
+ *
+ * The scheduler runs every callback registered with the same period from a
+ * single #GSource, so many graphs ticking at the same rate wake the main
+ * loop once per period instead of once per graph.  Ticks are aligned to
+ * multiples of the period on the monotonic clock, so timers whose periods
+ * divide one another also fire together.
+ *
+ * The scheduler belongs to the default main context and must only be used
+ * from the thread running it.
+ */
+
+typedef struct
+{
+	guint       id;
+	GSourceFunc func;
+	gpointer    data;
+} Subscriber;
+
+typedef struct
+{
+	GSource  source;
+	gint64   period;      /* Microseconds between ticks. */
+	gint64   next;        /* Monotonic time of the next tick. */
+	GArray  *subscribers; /* Array of Subscriber. */
+	gboolean dispatching; /* Removed subscribers are compacted later. */
+} Timer;
+
+static GHashTable *timers;      /* Period => Timer. */
+static GHashTable *subscribers; /* Subscriber id => Timer. */
+static guint       last_id;
+
+/**
+ * uber_scheduler_timer_prepare:
+ * @source: A #Timer.
+ * @timeout: (out): A location for the time until the next tick.
+ *
+ * Reports how long the main loop may sleep before the next tick.
+ *
+ * Returns: %TRUE if the tick is due.
+ * Side effects: None.
+ */
+static gboolean
+uber_scheduler_timer_prepare (GSource *source,  /* IN */
+                              gint    *timeout) /* OUT */
+{
+	Timer *timer = (Timer *)source;
+	gint64 now;
+
+	now = g_source_get_time(source);
+	if (now >= timer->next) {
+		if (timeout) {
+			*timeout = 0;
+		}
+		return TRUE;
+	}
+	if (timeout) {
+		*timeout = (timer->next - now + 999) / 1000;
+	}
+	return FALSE;
+}
+
+/**
+ * uber_scheduler_timer_check:
+ * @source: A #Timer.
+ *
+ * Checks if the tick is due after the main loop wakes.
+ *
+ * Returns: %TRUE if the tick is due.
+ * Side effects: None.
+ */
+static gboolean
+uber_scheduler_timer_check (GSource *source) /* IN */
+{
+	return uber_scheduler_timer_prepare(source, NULL);
+}
+
+/**
+ * uber_scheduler_timer_dispatch:
+ * @source: A #Timer.
+ * @callback: Unused.
+ * @user_data: Unused.
+ *
+ * Calls every subscriber of the timer.  Subscribers returning %FALSE are
+ * removed.  Ticks missed while the main loop was busy are skipped rather
+ * than run back to back.
+ *
+ * Returns: %TRUE if the timer still has subscribers.
+ * Side effects: None.
+ */
+static gboolean
+uber_scheduler_timer_dispatch (GSource     *source,    /* IN */
+                               GSourceFunc  callback,  /* IN */
+                               gpointer     user_data) /* IN */
+{
+	Timer *timer = (Timer *)source;
+	Subscriber *sub;
+	gint64 now;
+	guint n_subs;
+	guint i;
+
+	now = g_source_get_time(source);
+	timer->next = ((now / timer->period) + 1) * timer->period;
+	timer->dispatching = TRUE;
+	/*
+	 * Subscribers added during dispatch are appended and run on the next
+	 * tick, so only walk the ones present now.
+	 */
+	n_subs = timer->subscribers->len;
+	for (i = 0; i < n_subs; i++) {
+		sub = &g_array_index(timer->subscribers, Subscriber, i);
+		if (sub->func && !sub->func(sub->data)) {
+			/*
+			 * The callback may have removed itself, or others.
+			 */
+			sub = &g_array_index(timer->subscribers, Subscriber, i);
+			if (sub->func) {
+				g_hash_table_remove(subscribers, GUINT_TO_POINTER(sub->id));
+				sub->func = NULL;
+			}
+		}
+	}
+	timer->dispatching = FALSE;
+	/*
+	 * Drop the subscribers removed during this tick.
+	 */
+	for (i = timer->subscribers->len; i > 0; i--) {
+		sub = &g_array_index(timer->subscribers, Subscriber, i - 1);
+		if (!sub->func) {
+			g_array_remove_index(timer->subscribers, i - 1);
+		}
+	}
+	if (!timer->subscribers->len) {
+		g_hash_table_remove(timers, &timer->period);
+		return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * uber_scheduler_timer_finalize:
+ * @source: A #Timer.
+ *
+ * Releases the subscriber list of the timer.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static void
+uber_scheduler_timer_finalize (GSource *source) /* IN */
+{
+	Timer *timer = (Timer *)source;
+
+	g_array_unref(timer->subscribers);
+}
+
+static GSourceFuncs timer_funcs = {
+	uber_scheduler_timer_prepare,
+	uber_scheduler_timer_check,
+	uber_scheduler_timer_dispatch,
+	uber_scheduler_timer_finalize,
+};
+
+/**
+ * uber_scheduler_get_timer:
+ * @period: The period in microseconds.
+ *
+ * Retrieves the timer for @period, creating it if needed.
+ *
+ * Returns: A #Timer owned by the scheduler.
+ * Side effects: None.
+ */
+static Timer*
+uber_scheduler_get_timer (gint64 period) /* IN */
+{
+	Timer *timer;
+
+	if (G_UNLIKELY(!timers)) {
+		timers = g_hash_table_new(g_int64_hash, g_int64_equal);
+		subscribers = g_hash_table_new(g_direct_hash, g_direct_equal);
+	}
+	if (!(timer = g_hash_table_lookup(timers, &period))) {
+		timer = (Timer *)g_source_new(&timer_funcs, sizeof(Timer));
+		timer->period = period;
+		timer->next = ((g_get_monotonic_time() / period) + 1) * period;
+		timer->subscribers = g_array_new(FALSE, FALSE, sizeof(Subscriber));
+		g_source_set_name((GSource *)timer, "UberScheduler");
+		g_source_attach((GSource *)timer, NULL);
+		g_source_unref((GSource *)timer);
+		g_hash_table_insert(timers, &timer->period, timer);
+	}
+	return timer;
+}
+
+/**
+ * uber_scheduler_add:
+ * @period: The time between calls, in microseconds.
+ * @func: The function to call.
+ * @data: Data for @func.
+ *
+ * Calls @func every @period microseconds until it returns %FALSE or is
+ * removed with uber_scheduler_remove().  Every function added with the
+ * same period is called from the same main loop dispatch, so redraws they
+ * queue land in the same frame.
+ *
+ * Returns: An identifier for uber_scheduler_remove(), greater than 0.
+ * Side effects: None.
+ */
+guint
+uber_scheduler_add (gint64      period, /* IN */
+                    GSourceFunc func,   /* IN */
+                    gpointer    data)   /* IN */
+{
+	Subscriber sub;
+	Timer *timer;
+
+	g_return_val_if_fail(period > 0, 0);
+	g_return_val_if_fail(func != NULL, 0);
+
+	timer = uber_scheduler_get_timer(period);
+	sub.id = ++last_id;
+	sub.func = func;
+	sub.data = data;
+	g_array_append_val(timer->subscribers, sub);
+	g_hash_table_insert(subscribers, GUINT_TO_POINTER(sub.id), timer);
+	return sub.id;
+}
+
+/**
+ * uber_scheduler_remove:
+ * @id: An identifier returned from uber_scheduler_add().
+ *
+ * Stops calling the function registered as @id.  The timer it shared is
+ * destroyed once it has no functions left.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_scheduler_remove (guint id) /* IN */
+{
+	Subscriber *sub;
+	Timer *timer;
+	guint i;
+
+	if (!subscribers ||
+	    !(timer = g_hash_table_lookup(subscribers, GUINT_TO_POINTER(id)))) {
+		g_warning("%s(): No scheduled function with id %u.", G_STRFUNC, id);
+		return;
+	}
+	g_hash_table_remove(subscribers, GUINT_TO_POINTER(id));
+	for (i = 0; i < timer->subscribers->len; i++) {
+		sub = &g_array_index(timer->subscribers, Subscriber, i);
+		if (sub->id == id) {
+			/*
+			 * Entries are only marked during dispatch so the walk in
+			 * progress keeps valid indexes.
+			 */
+			if (timer->dispatching) {
+				sub->func = NULL;
+			} else {
+				g_array_remove_index(timer->subscribers, i);
+			}
+			break;
+		}
+	}
+	if (!timer->subscribers->len) {
+		g_hash_table_remove(timers, &timer->period);
+		g_source_destroy((GSource *)timer);
+	}
+}
@@ -0,0 +1,366 @@
+/* uber-series-ring.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "uber-series-ring.h"
+
+/**
+ * uber_series_ring_fill:
+ * @values: An array of #gdouble.
+ * @n_values: The number of elements in @values.
+ *
+ * Marks every element of @values as having no value.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_series_ring_fill (gdouble *values,   /* IN */
+                       gsize    n_values) /* IN */
+{
+	gsize i;
+
+	for (i = 0; i < n_values; i++) {
+		values[i] = NAN;
+	}
+}
+
+/**
+ * uber_series_ring_fill_times:
+ * @times: An array of #gint64.
+ * @n_times: The number of elements in @times.
+ *
+ * Marks every element of @times as never written.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_series_ring_fill_times (gint64 *times,   /* IN */
+                             gsize   n_times) /* IN */
+{
+	gsize i;
+
+	for (i = 0; i < n_times; i++) {
+		times[i] = G_MININT64;
+	}
+}
+
+/**
+ * uber_series_ring_copy_row:
+ * @ring: An #UberSeriesRing.
+ * @dst: The destination slot.
+ * @src: The source slot.
+ *
+ * Copies the row in slot @src, including its time, to slot @dst.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+static inline void
+uber_series_ring_copy_row (UberSeriesRing *ring, /* IN */
+                           guint           dst,  /* IN */
+                           guint           src)  /* IN */
+{
+	gdouble *data;
+	guint i;
+
+	data = ring->data;
+	for (i = 0; i < ring->n_series; i++, data += ring->len) {
+		data[dst] = data[src];
+	}
+	ring->times[dst] = ring->times[src];
+}
+
+/**
+ * uber_series_ring_new:
+ * @len: The number of rows to hold.
+ *
+ * Creates a new #UberSeriesRing holding @len rows and no series.
+ *
+ * Returns: A new #UberSeriesRing which should be freed with
+ *   uber_series_ring_free().
+ * Side effects: None.
+ */
+UberSeriesRing*
+uber_series_ring_new (guint len) /* IN */
+{
+	UberSeriesRing *ring;
+
+	ring = g_slice_new0(UberSeriesRing);
+	ring->len = len;
+	ring->times = g_new(gint64, len);
+	uber_series_ring_fill_times(ring->times, len);
+	return ring;
+}
+
+/**
+ * uber_series_ring_free:
+ * @ring: An #UberSeriesRing.
+ *
+ * Frees @ring and all of its values.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_series_ring_free (UberSeriesRing *ring) /* IN */
+{
+	if (ring) {
+		g_free(ring->data);
+		g_free(ring->times);
+		g_slice_free(UberSeriesRing, ring);
+	}
+}
+
+/**
+ * uber_series_ring_add_series:
+ * @ring: An #UberSeriesRing.
+ *
+ * Adds a new series to @ring.  Every slot of the new series is set to
+ * %NAN.
+ *
+ * Returns: The index of the new series.
+ * Side effects: None.
+ */
+guint
+uber_series_ring_add_series (UberSeriesRing *ring) /* IN */
+{
+	g_return_val_if_fail(ring != NULL, 0);
+
+	ring->data = g_renew(gdouble, ring->data,
+	                     (gsize)(ring->n_series + 1) * ring->len);
+	uber_series_ring_fill(uber_series_ring_get_series(ring, ring->n_series),
+	                      ring->len);
+	return ring->n_series++;
+}
+
+/**
+ * uber_series_ring_append_row:
+ * @ring: An #UberSeriesRing.
+ * @time: The monotonic time of the row.
+ * @row: An array of @ring->n_series values.
+ *
+ * Adds a value to every series at once.  @row[i] is stored in series i.
+ *
+ * Rows are kept in time order.  Usually @time is the newest and the row
+ * becomes index 0.  A late row is inserted behind any newer rows, which
+ * are shifted forward by one slot.  A row older than every row held by a
+ * full ring is dropped.
+ *
+ * Returns: The index of the new row, or -1 if it was dropped.
+ * Side effects: None.
+ */
+gint
+uber_series_ring_append_row (UberSeriesRing *ring, /* IN */
+                             gint64          time, /* IN */
+                             const gdouble  *row)  /* IN */
+{
+	gdouble *dst;
+	guint slot;
+	guint src;
+	guint n_newer = 0;
+	guint i;
+
+	g_return_val_if_fail(ring != NULL, -1);
+	g_return_val_if_fail(row != NULL || ring->n_series == 0, -1);
+
+	if (!ring->len) {
+		return -1;
+	}
+	/*
+	 * Count the rows that are newer than this one.  This is almost always
+	 * zero, so the scan stops on the first comparison.
+	 */
+	while (n_newer < ring->len &&
+	       uber_series_ring_get_time(ring, n_newer) > time) {
+		n_newer++;
+	}
+	if (n_newer == ring->len) {
+		return -1;
+	}
+	/*
+	 * Move the newer rows forward one slot, overwriting the oldest row, to
+	 * open a slot at the right position.
+	 */
+	slot = ring->pos;
+	for (i = 0; i < n_newer; i++) {
+		src = (slot + ring->len - 1) % ring->len;
+		uber_series_ring_copy_row(ring, slot, src);
+		slot = src;
+	}
+	dst = ring->data + slot;
+	for (i = 0; i < ring->n_series; i++, dst += ring->len) {
+		*dst = row[i];
+	}
+	ring->times[slot] = time;
+	ring->pos = (ring->pos + 1) % ring->len;
+	return n_newer;
+}
+
+/**
+ * uber_series_ring_get_spans:
+ * @ring: An #UberSeriesRing.
+ * @series: The series index.
+ * @spans: (out): A location for up to two #GRingSpan.
+ *
+ * Retrieves the values of @series as contiguous runs of memory in
+ * chronological order, in the same fashion as g_ring_get_spans().
+ *
+ * Returns: The number of non-empty spans.
+ * Side effects: None.
+ */
+guint
+uber_series_ring_get_spans (UberSeriesRing *ring,     /* IN */
+                            guint           series,   /* IN */
+                            GRingSpan       spans[2]) /* OUT */
+{
+	gdouble *base;
+	guint n_spans = 0;
+
+	g_return_val_if_fail(ring != NULL, 0);
+	g_return_val_if_fail(series < ring->n_series, 0);
+	g_return_val_if_fail(spans != NULL, 0);
+
+	memset(spans, 0, sizeof(GRingSpan) * 2);
+	base = uber_series_ring_get_series(ring, series);
+	if (ring->pos < ring->len) {
+		spans[n_spans].data = base + ring->pos;
+		spans[n_spans].len = ring->len - ring->pos;
+		n_spans++;
+	}
+	if (ring->pos > 0) {
+		spans[n_spans].data = base;
+		spans[n_spans].len = ring->pos;
+		n_spans++;
+	}
+	return n_spans;
+}
+
+/**
+ * uber_series_ring_get_time_spans:
+ * @ring: An #UberSeriesRing.
+ * @spans: (out): A location for up to two #GRingSpan.
+ *
+ * Retrieves the row times as contiguous runs of memory.  The spans have
+ * the same lengths as those from uber_series_ring_get_spans(), so they may
+ * be walked side by side.
+ *
+ * Returns: The number of non-empty spans.
+ * Side effects: None.
+ */
+guint
+uber_series_ring_get_time_spans (UberSeriesRing *ring,     /* IN */
+                                 GRingSpan       spans[2]) /* OUT */
+{
+	guint n_spans = 0;
+
+	g_return_val_if_fail(ring != NULL, 0);
+	g_return_val_if_fail(spans != NULL, 0);
+
+	memset(spans, 0, sizeof(GRingSpan) * 2);
+	if (ring->pos < ring->len) {
+		spans[n_spans].data = ring->times + ring->pos;
+		spans[n_spans].len = ring->len - ring->pos;
+		n_spans++;
+	}
+	if (ring->pos > 0) {
+		spans[n_spans].data = ring->times;
+		spans[n_spans].len = ring->pos;
+		n_spans++;
+	}
+	return n_spans;
+}
+
+/**
+ * uber_series_ring_resize:
+ * @ring: An #UberSeriesRing.
+ * @len: The new number of rows.
+ *
+ * Changes the number of rows held by @ring.  The newest rows are preserved;
+ * rows added when growing are set to %NAN.  All series are moved into a
+ * single new allocation and the row times follow their rows.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_series_ring_resize (UberSeriesRing *ring, /* IN */
+                         guint           len)  /* IN */
+{
+	GRingSpan spans[2];
+	gdouble *data;
+	gint64 *times;
+	gdouble *dst;
+	gint64 *tdst;
+	guint n_spans;
+	guint keep;
+	guint skip;
+	guint drop;
+	guint i;
+	guint j;
+
+	g_return_if_fail(ring != NULL);
+
+	if (len == ring->len) {
+		return;
+	}
+	data = g_new(gdouble, (gsize)ring->n_series * len);
+	keep = MIN(len, ring->len);
+	for (i = 0; i < ring->n_series; i++) {
+		/*
+		 * Lay the series out oldest to newest, with any new slots being
+		 * the oldest values.
+		 */
+		dst = data + ((gsize)i * len);
+		uber_series_ring_fill(dst, len - keep);
+		dst += len - keep;
+		skip = ring->len - keep;
+		n_spans = uber_series_ring_get_spans(ring, i, spans);
+		for (j = 0; j < n_spans; j++) {
+			drop = MIN(skip, spans[j].len);
+			skip -= drop;
+			memcpy(dst, (gdouble *)spans[j].data + drop,
+			       (spans[j].len - drop) * sizeof(gdouble));
+			dst += spans[j].len - drop;
+		}
+	}
+	/*
+	 * Row times are laid out the same way.
+	 */
+	times = g_new(gint64, len);
+	uber_series_ring_fill_times(times, len - keep);
+	tdst = times + (len - keep);
+	skip = ring->len - keep;
+	n_spans = uber_series_ring_get_time_spans(ring, spans);
+	for (j = 0; j < n_spans; j++) {
+		drop = MIN(skip, spans[j].len);
+		skip -= drop;
+		memcpy(tdst, (gint64 *)spans[j].data + drop,
+		       (spans[j].len - drop) * sizeof(gint64));
+		tdst += spans[j].len - drop;
+	}
+	g_free(ring->data);
+	g_free(ring->times);
+	ring->data = data;
+	ring->times = times;
+	ring->len = len;
+	ring->pos = 0;
+}
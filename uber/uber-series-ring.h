@@ -0,0 +1,119 @@
+/* uber-series-ring.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_SERIES_RING_H__
+#define __UBER_SERIES_RING_H__
+
+#include <glib.h>
+
+#include "g-ring.h"
+
+G_BEGIN_DECLS
+
+/**
+ * uber_series_ring_get_series:
+ * @ring: An #UberSeriesRing.
+ * @series: The series index.
+ *
+ * Retrieves the base of the storage for @series.  The storage is @ring->len
+ * values long and is laid out as a ring; see uber_series_ring_get_spans().
+ *
+ * Returns: A pointer to the values of @series.
+ * Side effects: None.
+ */
+#define uber_series_ring_get_series(ring, series) \
+    ((ring)->data + ((gsize)(series) * (ring)->len))
+
+/**
+ * uber_series_ring_get_index:
+ * @ring: An #UberSeriesRing.
+ * @series: The series index.
+ * @i: The index within the series relative to the current position.
+ *
+ * Retrieves the value at the given index of @series.  Index 0 is the most
+ * recently appended row.  Like g_ring_get_index(), the result may be
+ * assigned to.
+ *
+ * Returns: The value at the given index.
+ * Side effects: None.
+ */
+#define uber_series_ring_get_index(ring, series, i)                     \
+    (uber_series_ring_get_series((ring), (series))                      \
+        [(((gint)(ring)->pos - 1 - (gint)(i)) >= 0) ?                   \
+          ((ring)->pos - 1 - (i)) :                                     \
+          ((ring)->len + ((ring)->pos - 1 - (i)))])
+
+/**
+ * uber_series_ring_get_time:
+ * @ring: An #UberSeriesRing.
+ * @i: The index relative to the current position.
+ *
+ * Retrieves the time of the row at the given index.  Index 0 is the newest
+ * row.
+ *
+ * Returns: The time of the row, or %G_MININT64 if it was never written.
+ * Side effects: None.
+ */
+#define uber_series_ring_get_time(ring, i)                              \
+    ((ring)->times[(((gint)(ring)->pos - 1 - (gint)(i)) >= 0) ?          \
+                   ((ring)->pos - 1 - (i)) :                            \
+                   ((ring)->len + ((ring)->pos - 1 - (i)))])
+
+/**
+ * UberSeriesRing:
+ * @data: The values of every series.  Each series owns a contiguous block of
+ *   @len values, and the blocks are stored one after another.
+ * @times: The time of each row, laid out like a single series.
+ * @len: The number of rows held for each series.
+ * @pos: The slot the next row will be written to.
+ * @n_series: The number of series.
+ *
+ * A ring buffer of rows of #gdouble values where every series shares a
+ * single write position.  Rows are appended in one call while each series
+ * remains contiguous in memory so it can be scanned in a tight loop.
+ *
+ * Every row carries the monotonic time it was sampled at and rows are kept
+ * in time order.  Every slot always holds a value; slots that were never
+ * written contain %NAN and have a time of %G_MININT64.
+ */
+typedef struct
+{
+	gdouble *data;
+	gint64  *times;
+	guint    len;
+	guint    pos;
+	guint    n_series;
+} UberSeriesRing;
+
+UberSeriesRing* uber_series_ring_new            (guint           len);
+void            uber_series_ring_free           (UberSeriesRing *ring);
+guint           uber_series_ring_add_series     (UberSeriesRing *ring);
+gint            uber_series_ring_append_row     (UberSeriesRing *ring,
+                                                 gint64          time,
+                                                 const gdouble  *row);
+guint           uber_series_ring_get_spans      (UberSeriesRing *ring,
+                                                 guint           series,
+                                                 GRingSpan       spans[2]);
+guint           uber_series_ring_get_time_spans (UberSeriesRing *ring,
+                                                 GRingSpan       spans[2]);
+void            uber_series_ring_resize         (UberSeriesRing *ring,
+                                                 guint           len);
+
+G_END_DECLS
+
+#endif /* __UBER_SERIES_RING_H__ */
@@ -0,0 +1,205 @@
+/* uber-spsc-queue.c
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "uber-spsc-queue.h"
+
+/*
+ * UberSpscQueue is a bounded queue of fixed size elements.  Exactly one
+ * thread may push elements while exactly one other thread pops them.
+ * Neither side ever takes a lock; each only publishes its own cursor.
+ *
+ * The cursors are free running counters that are masked into the buffer,
+ * so the capacity is always a power of two.
+ */
+
+#define CACHELINE_SIZE 64
+
+struct _UberSpscQueue
+{
+	guint8 *data;
+	guint   elt_size;
+	guint   mask;
+	/*
+	 * Owned by the producer.  @head_cache is the last value of @head it
+	 * observed.
+	 */
+	gint    tail;
+	guint   head_cache;
+	guint8  pad1[CACHELINE_SIZE - (sizeof(gint) + sizeof(guint))];
+	/*
+	 * Owned by the consumer.  @tail_cache is the last value of @tail it
+	 * observed.
+	 */
+	gint    head;
+	guint   tail_cache;
+	guint8  pad2[CACHELINE_SIZE - (sizeof(gint) + sizeof(guint))];
+};
+
+/**
+ * uber_spsc_queue_new:
+ * @elt_size: The size of each element.
+ * @capacity: The minimum number of elements the queue can hold.
+ *
+ * Creates a new #UberSpscQueue.  @capacity is rounded up to the next
+ * power of two.
+ *
+ * Returns: A new #UberSpscQueue which should be freed with
+ *   uber_spsc_queue_free().
+ * Side effects: None.
+ */
+UberSpscQueue*
+uber_spsc_queue_new (guint elt_size, /* IN */
+                     guint capacity) /* IN */
+{
+	UberSpscQueue *queue;
+	guint len = 1;
+
+	g_return_val_if_fail(elt_size > 0, NULL);
+	g_return_val_if_fail(capacity > 0, NULL);
+	g_return_val_if_fail(capacity <= G_MAXINT / 2, NULL);
+
+	while (len < capacity) {
+		len <<= 1;
+	}
+	queue = g_new0(UberSpscQueue, 1);
+	queue->data = g_malloc((gsize)elt_size * len);
+	queue->elt_size = elt_size;
+	queue->mask = len - 1;
+	return queue;
+}
+
+/**
+ * uber_spsc_queue_free:
+ * @queue: An #UberSpscQueue.
+ *
+ * Frees @queue.  Neither the producer nor the consumer may use @queue
+ * after this is called.
+ *
+ * Returns: None.
+ * Side effects: None.
+ */
+void
+uber_spsc_queue_free (UberSpscQueue *queue) /* IN */
+{
+	if (queue) {
+		g_free(queue->data);
+		g_free(queue);
+	}
+}
+
+/**
+ * uber_spsc_queue_push:
+ * @queue: An #UberSpscQueue.
+ * @elts: An array of @n_elts elements.
+ * @n_elts: The number of elements in @elts.
+ *
+ * Pushes @n_elts elements onto the queue.  Either all of the elements are
+ * pushed or, if there is not enough room, none of them are.  This may only
+ * be called from the producer thread.
+ *
+ * Returns: %TRUE if the elements were pushed; otherwise %FALSE.
+ * Side effects: None.
+ */
+gboolean
+uber_spsc_queue_push (UberSpscQueue *queue,  /* IN */
+                      gconstpointer  elts,   /* IN */
+                      guint          n_elts) /* IN */
+{
+	guint capacity;
+	guint tail;
+	guint off;
+	guint run;
+
+	g_return_val_if_fail(queue != NULL, FALSE);
+	g_return_val_if_fail(elts != NULL || n_elts == 0, FALSE);
+
+	capacity = queue->mask + 1;
+	tail = (guint)queue->tail;
+	/*
+	 * Only reload the consumers cursor when the cached copy says there is
+	 * not enough room.
+	 */
+	if ((tail - queue->head_cache) + n_elts > capacity) {
+		queue->head_cache = (guint)g_atomic_int_get(&queue->head);
+		if ((tail - queue->head_cache) + n_elts > capacity) {
+			return FALSE;
+		}
+	}
+	/*
+	 * Copy in at most two runs, then publish the new tail.
+	 */
+	off = tail & queue->mask;
+	run = MIN(n_elts, capacity - off);
+	memcpy(queue->data + ((gsize)off * queue->elt_size), elts,
+	       (gsize)run * queue->elt_size);
+	memcpy(queue->data, (const guint8 *)elts + ((gsize)run * queue->elt_size),
+	       (gsize)(n_elts - run) * queue->elt_size);
+	g_atomic_int_set(&queue->tail, (gint)(tail + n_elts));
+	return TRUE;
+}
+
+/**
+ * uber_spsc_queue_pop:
+ * @queue: An #UberSpscQueue.
+ * @elts: (out): A location for up to @max_elts elements.
+ * @max_elts: The maximum number of elements to pop.
+ *
+ * Pops up to @max_elts elements from the queue in the order they were
+ * pushed.  This may only be called from the consumer thread.
+ *
+ * Returns: The number of elements stored in @elts.
+ * Side effects: None.
+ */
+guint
+uber_spsc_queue_pop (UberSpscQueue *queue,    /* IN */
+                     gpointer       elts,     /* OUT */
+                     guint          max_elts) /* IN */
+{
+	guint capacity;
+	guint head;
+	guint off;
+	guint run;
+	guint n_elts;
+
+	g_return_val_if_fail(queue != NULL, 0);
+	g_return_val_if_fail(elts != NULL || max_elts == 0, 0);
+
+	capacity = queue->mask + 1;
+	head = (guint)queue->head;
+	if (queue->tail_cache == head) {
+		queue->tail_cache = (guint)g_atomic_int_get(&queue->tail);
+	}
+	n_elts = MIN(queue->tail_cache - head, max_elts);
+	if (!n_elts) {
+		return 0;
+	}
+	/*
+	 * Copy out in at most two runs, then release the slots to the
+	 * producer.
+	 */
+	off = head & queue->mask;
+	run = MIN(n_elts, capacity - off);
+	memcpy(elts, queue->data + ((gsize)off * queue->elt_size),
+	       (gsize)run * queue->elt_size);
+	memcpy((guint8 *)elts + ((gsize)run * queue->elt_size), queue->data,
+	       (gsize)(n_elts - run) * queue->elt_size);
+	g_atomic_int_set(&queue->head, (gint)(head + n_elts));
+	return n_elts;
+}
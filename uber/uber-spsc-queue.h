@@ -0,0 +1,40 @@
+/* uber-spsc-queue.h
+ *
+ * Copyright (C) 2010 Christian Hergert <chris@dronelabs.com>
+ *
+ * This file is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __UBER_SPSC_QUEUE_H__
+#define __UBER_SPSC_QUEUE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _UberSpscQueue UberSpscQueue;
+
+UberSpscQueue* uber_spsc_queue_new    (guint          elt_size,
+                                       guint          capacity);
+void           uber_spsc_queue_free   (UberSpscQueue *queue);
+gboolean       uber_spsc_queue_push   (UberSpscQueue *queue,
+                                       gconstpointer  elts,
+                                       guint          n_elts);
+guint          uber_spsc_queue_pop    (UberSpscQueue *queue,
+                                       gpointer       elts,
+                                       guint          max_elts);
+
+G_END_DECLS
+
+#endif /* __UBER_SPSC_QUEUE_H__ */
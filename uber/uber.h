@@ -22,6 +22,7 @@
 #include "uber-graph.h"
 #include "uber-line-graph.h"
 #include "uber-heat-map.h"
+#include "uber-histogram.h"
 #include "uber-range.h"
 #include "uber-scatter.h"
 #include "uber-scale.h"